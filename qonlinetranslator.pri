@@ -3,12 +3,25 @@ QT += network multimedia
 HEADERS += $$PWD/src/qonlinetranslator.h \
     $$PWD/src/qonlinetts.h \
     $$PWD/src/qexample.h \
-    $$PWD/src/qoption.h
+    $$PWD/src/qoption.h \
+    $$PWD/src/qtranslationcache.h \
+    $$PWD/src/qjsonstreamreader.h \
+    $$PWD/src/qgooglereplyreader.h \
+    $$PWD/src/qlanguageidentifier.h \
+    $$PWD/src/qtransliterator.h \
+    $$PWD/src/qenginecapabilities.h \
+    $$PWD/src/qtextsplitter.h
 
 SOURCES += $$PWD/src/qonlinetranslator.cpp \
     $$PWD/src/qonlinetts.cpp \
     $$PWD/src/qexample.cpp \
-    $$PWD/src/qoption.cpp
+    $$PWD/src/qoption.cpp \
+    $$PWD/src/qtranslationcache.cpp \
+    $$PWD/src/qjsonstreamreader.cpp \
+    $$PWD/src/qgooglereplyreader.cpp \
+    $$PWD/src/qlanguageidentifier.cpp \
+    $$PWD/src/qtransliterator.cpp \
+    $$PWD/src/qtextsplitter.cpp
 
 INCLUDEPATH += $$PWD/src
 
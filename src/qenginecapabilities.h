@@ -0,0 +1,596 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef QENGINECAPABILITIES_H
+#define QENGINECAPABILITIES_H
+
+// Capabilities of engines, the single source for the support tables that qonlinetranslator.cpp generates at compile time.
+// Not a part of the public API, included only by the library and its tests.
+
+#include "qonlinetranslator.h"
+
+constexpr bool QOnlineTranslator::hasTranslation(Engine engine, Language lang)
+{
+    bool isSupported = false;
+
+    switch (engine) {
+    case Google:
+    case Lingva: // Lingva is a frontend to Google Translate
+        switch (lang) {
+        case NoLanguage:
+        case Bashkir:
+        case Cantonese:
+        case Fijian:
+        case Filipino:
+        case Georgian:
+        case HillMari:
+        case Klingon:
+        case KlingonPlqaD:
+        case LevantineArabic:
+        case Mari:
+        case Papiamento:
+        case QueretaroOtomi:
+        case SerbianLatin:
+        case Tahitian:
+        case Tongan:
+        case Udmurt:
+        case YucatecMaya:
+            isSupported = false;
+            break;
+        default:
+            isSupported = true;
+            break;
+        }
+        break;
+    case Yandex:
+        switch (lang) {
+        case NoLanguage:
+        case Cantonese:
+        case Chichewa:
+        case Corsican:
+        case Fijian:
+        case Filipino:
+        case Frisian:
+        case Hausa:
+        case Hawaiian:
+        case Igbo:
+        case Kinyarwanda:
+        case Klingon:
+        case KlingonPlqaD:
+        case Kurdish:
+        case LevantineArabic:
+        case Oriya:
+        case Pashto:
+        case QueretaroOtomi:
+        case Samoan:
+        case SerbianLatin:
+        case Sesotho:
+        case Shona:
+        case Sindhi:
+        case Somali:
+        case Tahitian:
+        case Tongan:
+        case Turkmen:
+        case Uighur:
+        case Yoruba:
+        case YucatecMaya:
+        case Zulu:
+            isSupported = false;
+            break;
+        default:
+            isSupported = true;
+            break;
+        }
+        break;
+    case Bing:
+        switch (lang) {
+        case NoLanguage:
+        case Albanian:
+        case Amharic:
+        case Armenian:
+        case Azerbaijani:
+        case Basque:
+        case Bashkir:
+        case Belarusian:
+        case Cebuano:
+        case Corsican:
+        case Esperanto:
+        case Frisian:
+        case Galician:
+        case Georgian:
+        case Gujarati:
+        case Hausa:
+        case Hawaiian:
+        case HillMari:
+        case Igbo:
+        case Irish:
+        case Javanese:
+        case Kannada:
+        case Kazakh:
+        case Khmer:
+        case Kinyarwanda:
+        case Kurdish:
+        case Kyrgyz:
+        case Lao:
+        case Latin:
+        case Luxembourgish:
+        case Macedonian:
+        case Malayalam:
+        case Maori:
+        case Marathi:
+        case Mari:
+        case Mongolian:
+        case Myanmar:
+        case Nepali:
+        case Oriya:
+        case Chichewa:
+        case Papiamento:
+        case Pashto:
+        case Punjabi:
+        case ScotsGaelic:
+        case Sesotho:
+        case Shona:
+        case Sindhi:
+        case Sinhala:
+        case Somali:
+        case Sundanese:
+        case Tagalog:
+        case Tajik:
+        case Tatar:
+        case Turkmen:
+        case Uighur:
+        case Udmurt:
+        case Uzbek:
+        case Xhosa:
+        case Yiddish:
+        case Yoruba:
+        case Zulu:
+            isSupported = false;
+            break;
+        default:
+            isSupported = true;
+            break;
+        }
+        break;
+    case LibreTranslate:
+        switch (lang) {
+        case NoLanguage:
+        case Afrikaans:
+        case Amharic:
+        case Armenian:
+        case Bashkir:
+        case Basque:
+        case Belarusian:
+        case Bosnian:
+        case Cantonese:
+        case Cebuano:
+        case Chichewa:
+        case Corsican:
+        case Croatian:
+        case Fijian:
+        case Filipino:
+        case Frisian:
+        case Galician:
+        case Georgian:
+        case Gujarati:
+        case HaitianCreole:
+        case Hausa:
+        case Hawaiian:
+        case HillMari:
+        case Hmong:
+        case Icelandic:
+        case Igbo:
+        case Javanese:
+        case Kannada:
+        case Kazakh:
+        case Khmer:
+        case Kinyarwanda:
+        case Klingon:
+        case KlingonPlqaD:
+        case Kurdish:
+        case Kyrgyz:
+        case Lao:
+        case Latin:
+        case LevantineArabic:
+        case Luxembourgish:
+        case Macedonian:
+        case Malagasy:
+        case Malayalam:
+        case Maltese:
+        case Maori:
+        case Marathi:
+        case Mari:
+        case Mongolian:
+        case Myanmar:
+        case Nepali:
+        case Oriya:
+        case Papiamento:
+        case Pashto:
+        case Punjabi:
+        case QueretaroOtomi:
+        case Samoan:
+        case ScotsGaelic:
+        case SerbianCyrillic:
+        case SerbianLatin:
+        case Sesotho:
+        case Shona:
+        case SimplifiedChinese:
+        case Sindhi:
+        case Sinhala:
+        case Somali:
+        case Sundanese:
+        case Swahili:
+        case Tahitian:
+        case Tajik:
+        case Tamil:
+        case Tatar:
+        case Telugu:
+        case Tongan:
+        case Turkmen:
+        case Udmurt:
+        case Uighur:
+        case Urdu:
+        case Uzbek:
+        case Welsh:
+        case Xhosa:
+        case Yiddish:
+        case Yoruba:
+        case YucatecMaya:
+        case Zulu:
+            isSupported = false;
+            break;
+        default:
+            isSupported = true;
+            break;
+        }
+        break;
+    }
+
+    return isSupported;
+}
+
+constexpr bool QOnlineTranslator::hasTranslit(Engine engine, Language lang)
+{
+    switch (engine) {
+    case Google:
+    case Lingva:
+        return hasTranslation(Google, lang); // Google supports transliteration for all supported languages
+    case Yandex:
+        switch (lang) {
+        case Amharic:
+        case Armenian:
+        case Bengali:
+        case SimplifiedChinese:
+        case Georgian:
+        case Greek:
+        case Gujarati:
+        case Hebrew:
+        case Hindi:
+        case Japanese:
+        case Kannada:
+        case Korean:
+        case Malayalam:
+        case Marathi:
+        case Nepali:
+        case Punjabi:
+        case Russian:
+        case Sinhala:
+        case Tamil:
+        case Telugu:
+        case Thai:
+        case Yiddish:
+            return true;
+        default:
+            return false;
+        }
+    case Bing:
+        switch (lang) {
+        case Arabic:
+        case Bengali:
+        case Gujarati:
+        case Hebrew:
+        case Hindi:
+        case Japanese:
+        case Kannada:
+        case Malayalam:
+        case Marathi:
+        case Punjabi:
+        case SerbianCyrillic:
+        case SerbianLatin:
+        case Tamil:
+        case Telugu:
+        case Thai:
+        case SimplifiedChinese:
+        case TraditionalChinese:
+            return true;
+        default:
+            return false;
+        }
+    case LibreTranslate: // LibreTranslate doesn't support translit
+        return false;
+    }
+
+    return false;
+}
+
+constexpr bool QOnlineTranslator::hasDictionary(Engine engine, Language sourceLang, Language translationLang)
+{
+    switch (engine) {
+    case Google:
+        return hasTranslation(Google, sourceLang) && hasTranslation(Google, translationLang); // Google supports dictionary for all supported languages
+    case Yandex:
+        switch (sourceLang) {
+        case Belarusian:
+            switch (translationLang) {
+            case Belarusian:
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case Bulgarian:
+            switch (translationLang) {
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case Czech:
+        case Danish:
+        case Dutch:
+        case Estonian:
+        case Greek:
+        case Latvian:
+        case Norwegian:
+        case Portuguese:
+        case Slovak:
+        case Swedish:
+            switch (translationLang) {
+            case English:
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case German:
+            switch (translationLang) {
+            case German:
+            case English:
+            case Russian:
+            case Turkish:
+                return true;
+            default:
+                return false;
+            }
+        case English:
+            switch (translationLang) {
+            case Czech:
+            case Danish:
+            case German:
+            case Greek:
+            case English:
+            case Spanish:
+            case Estonian:
+            case Finnish:
+            case French:
+            case Italian:
+            case Lithuanian:
+            case Latvian:
+            case Dutch:
+            case Norwegian:
+            case Portuguese:
+            case Russian:
+            case Slovak:
+            case Swedish:
+            case Turkish:
+            case Ukrainian:
+                return true;
+            default:
+                return false;
+            }
+        case Spanish:
+            switch (translationLang) {
+            case English:
+            case Spanish:
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case Finnish:
+            switch (translationLang) {
+            case English:
+            case Russian:
+            case Finnish:
+                return true;
+            default:
+                return false;
+            }
+        case French:
+            switch (translationLang) {
+            case French:
+            case English:
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case Hungarian:
+            switch (translationLang) {
+            case Hungarian:
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case Italian:
+            switch (translationLang) {
+            case English:
+            case Italian:
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case Lithuanian:
+            switch (translationLang) {
+            case English:
+            case Lithuanian:
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case Mari:
+        case HillMari:
+        case Polish:
+        case Tatar:
+            switch (translationLang) {
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case Russian:
+            switch (translationLang) {
+            case Belarusian:
+            case Bulgarian:
+            case Czech:
+            case Danish:
+            case German:
+            case Greek:
+            case English:
+            case Spanish:
+            case Estonian:
+            case Finnish:
+            case French:
+            case Italian:
+            case Lithuanian:
+            case Latvian:
+            case Mari:
+            case HillMari:
+            case Dutch:
+            case Norwegian:
+            case Portuguese:
+            case Russian:
+            case Slovak:
+            case Swedish:
+            case Turkish:
+            case Tatar:
+            case Ukrainian:
+                return true;
+            default:
+                return false;
+            }
+        case Turkish:
+            switch (translationLang) {
+            case German:
+            case English:
+            case Russian:
+                return true;
+            default:
+                return false;
+            }
+        case Ukrainian:
+            switch (translationLang) {
+            case English:
+            case Russian:
+            case Ukrainian:
+                return true;
+            default:
+                return false;
+            }
+        default:
+            return false;
+        }
+    case Bing: {
+        // Bing support dictionary only to or from English
+        Language secondLang = NoLanguage;
+        if (sourceLang == English)
+            secondLang = translationLang;
+        else if (translationLang == English)
+            secondLang = sourceLang;
+        else
+            return false;
+
+        switch (secondLang) {
+        case Afrikaans:
+        case Arabic:
+        case Bengali:
+        case Bosnian:
+        case Bulgarian:
+        case Catalan:
+        case SimplifiedChinese:
+        case Croatian:
+        case Czech:
+        case Danish:
+        case Dutch:
+        case Estonian:
+        case Finnish:
+        case French:
+        case German:
+        case Greek:
+        case HaitianCreole:
+        case Hebrew:
+        case Hindi:
+        case Hmong:
+        case Hungarian:
+        case Icelandic:
+        case Indonesian:
+        case Italian:
+        case Japanese:
+        case Swahili:
+        case Klingon:
+        case Korean:
+        case Latvian:
+        case Lithuanian:
+        case Malay:
+        case Maltese:
+        case Norwegian:
+        case Persian:
+        case Polish:
+        case Portuguese:
+        case Romanian:
+        case Russian:
+        case SerbianLatin:
+        case Slovak:
+        case Slovenian:
+        case Spanish:
+        case Swedish:
+        case Tamil:
+        case Thai:
+        case Turkish:
+        case Ukrainian:
+        case Urdu:
+        case Vietnamese:
+        case Welsh:
+            return true;
+        default:
+            return false;
+        }
+    }
+    case LibreTranslate: // LibreTranslate doesn't support dictinaries
+    case Lingva: // Although Lingvo is a frontend to Google Translate, it doesn't support dictionaries
+        return false;
+    }
+
+    return false;
+}
+
+#endif // QENGINECAPABILITIES_H
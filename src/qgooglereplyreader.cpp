@@ -0,0 +1,457 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "qgooglereplyreader.h"
+
+#include <cstring>
+
+namespace
+{
+bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+QString decodeString(const char *data, int size, bool escaped)
+{
+    if (!escaped)
+        return QString::fromUtf8(data, size);
+
+    // Escape sequences are ASCII, so they do not split UTF-8 sequences between them
+    QString text;
+    text.reserve(size);
+    int chunkBegin = 0;
+    for (int i = 0; i < size; ++i) {
+        if (data[i] != '\\')
+            continue;
+
+        text += QString::fromUtf8(data + chunkBegin, i - chunkBegin);
+        switch (data[++i]) {
+        case 'b':
+            text += QLatin1Char('\b');
+            break;
+        case 'f':
+            text += QLatin1Char('\f');
+            break;
+        case 'n':
+            text += QLatin1Char('\n');
+            break;
+        case 'r':
+            text += QLatin1Char('\r');
+            break;
+        case 't':
+            text += QLatin1Char('\t');
+            break;
+        case 'u':
+            // Surrogate pairs are written as two escape sequences, so each one is a single UTF-16 code unit
+            if (i + 4 < size) {
+                bool ok;
+                const ushort unicode = QByteArray::fromRawData(data + i + 1, 4).toUShort(&ok, 16);
+                if (ok)
+                    text += QChar(unicode);
+                i += 4;
+            }
+            break;
+        default:
+            text += QLatin1Char(data[i]);
+        }
+        chunkBegin = i + 1;
+    }
+    text += QString::fromUtf8(data + chunkBegin, size - chunkBegin);
+
+    return text;
+}
+}
+
+void QGoogleReplyReader::addData(const QByteArray &data)
+{
+    if (m_state == Failed)
+        return;
+
+    // Only an incomplete value is left from the previous chunk
+    m_buffer.remove(0, m_pos);
+    m_pos = 0;
+    m_buffer += data;
+
+    forever {
+        if (m_state == SkipValue) {
+            if (!skipValue())
+                return;
+            continue;
+        }
+
+        while (m_pos < m_buffer.size() && isWhitespace(m_buffer.at(m_pos)))
+            ++m_pos;
+
+        if (m_pos == m_buffer.size())
+            return;
+
+        const char c = m_buffer.at(m_pos);
+        switch (m_state) {
+        case ExpectDocument:
+            // HTML pages and other replies that are not arrays are rejected on the first byte
+            if (c != '[') {
+                setError();
+                return;
+            }
+
+            ++m_pos;
+            m_indexes[0] = 0;
+            m_depth = 1;
+            m_state = ExpectValueOrEnd;
+            break;
+        case ExpectValueOrEnd:
+            if (c == ']') {
+                closeArray();
+                break;
+            }
+            Q_FALLTHROUGH();
+        case ExpectValue:
+            if (!readValue(c))
+                return;
+            break;
+        case ExpectCommaOrEnd:
+            if (c == ',') {
+                ++m_pos;
+                ++m_indexes[m_depth - 1];
+                m_state = ExpectValue;
+            } else if (c == ']') {
+                closeArray();
+            } else {
+                setError();
+                return;
+            }
+            break;
+        case SkipValue:
+            break;
+        case Finished:
+        case Failed:
+            // Only whitespaces are allowed after the reply
+            setError();
+            return;
+        }
+    }
+}
+
+bool QGoogleReplyReader::atEnd() const
+{
+    return m_state == Finished;
+}
+
+bool QGoogleReplyReader::hasError() const
+{
+    return m_state == Failed;
+}
+
+void QGoogleReplyReader::setTranslationTranslitEnabled(bool enable)
+{
+    m_translationTranslitEnabled = enable;
+}
+
+void QGoogleReplyReader::setSourceTranslitEnabled(bool enable)
+{
+    m_sourceTranslitEnabled = enable;
+}
+
+void QGoogleReplyReader::setTranslationOptionsEnabled(bool enable)
+{
+    m_translationOptionsEnabled = enable;
+}
+
+void QGoogleReplyReader::setExamplesEnabled(bool enable)
+{
+    m_examplesEnabled = enable;
+}
+
+const QString &QGoogleReplyReader::translation() const
+{
+    return m_translation;
+}
+
+const QString &QGoogleReplyReader::translationTranslit() const
+{
+    return m_translationTranslit;
+}
+
+const QString &QGoogleReplyReader::sourceTranslit() const
+{
+    return m_sourceTranslit;
+}
+
+const QString &QGoogleReplyReader::sourceLanguageCode() const
+{
+    return m_sourceLanguageCode;
+}
+
+const QMap<QString, QVector<QOption>> &QGoogleReplyReader::translationOptions() const
+{
+    return m_translationOptions;
+}
+
+const QMap<QString, QVector<QExample>> &QGoogleReplyReader::examples() const
+{
+    return m_examples;
+}
+
+bool QGoogleReplyReader::readValue(char c)
+{
+    if (c == '[' && isUsedArray()) {
+        ++m_pos;
+        m_indexes[m_depth++] = 0;
+        m_state = ExpectValueOrEnd;
+        return true;
+    }
+
+    if (c == '"') {
+        const Field field = stringField();
+        if (field != NoField)
+            return readString(field);
+    }
+
+    m_skipDepth = 0;
+    m_skipInString = false;
+    m_skipEscape = false;
+    m_state = SkipValue;
+    return true;
+}
+
+bool QGoogleReplyReader::readString(Field field)
+{
+    // Continue from the place where the previous chunk ended
+    if (m_scanned == 0)
+        m_escaped = false;
+
+    // Text between quotes and backslashes is skipped with memchr()
+    const char *data = m_buffer.constData();
+    const int size = m_buffer.size();
+    int i = m_pos + 1 + m_scanned;
+    int quote = -1;
+    while (i < size) {
+        if (quote < i) {
+            const void *found = std::memchr(data + i, '"', size - i);
+            quote = found != nullptr ? static_cast<int>(static_cast<const char *>(found) - data) : size;
+        }
+
+        const void *backslash = std::memchr(data + i, '\\', quote - i);
+        if (backslash == nullptr) {
+            i = quote;
+            break;
+        }
+
+        i = static_cast<int>(static_cast<const char *>(backslash) - data);
+        if (i + 1 == size)
+            break;
+        m_escaped = true;
+        i += 2;
+    }
+
+    if (i == size || data[i] != '"') {
+        m_scanned = i - m_pos - 1;
+        return false;
+    }
+
+    const QString text = decodeString(data + m_pos + 1, i - m_pos - 1, m_escaped);
+    m_pos = i + 1;
+    m_scanned = 0;
+    m_state = ExpectCommaOrEnd;
+
+    switch (field) {
+    case NoField:
+        break;
+    case Translation:
+        m_translation += text;
+        break;
+    case TranslationTranslit:
+        m_translationTranslit += text;
+        break;
+    case SourceTranslit:
+        m_sourceTranslit += text;
+        break;
+    case SourceLanguage:
+        m_sourceLanguageCode = text;
+        break;
+    case TypeOfSpeech:
+        m_typeOfSpeech = text;
+        break;
+    case OptionWord:
+        m_option.word = text;
+        break;
+    case OptionGender:
+        m_option.gender = text;
+        break;
+    case OptionTranslation:
+        m_option.translations.append(text);
+        break;
+    case ExampleDescription:
+        m_example.description = text;
+        break;
+    case Example:
+        m_example.example = text;
+        break;
+    }
+    return true;
+}
+
+bool QGoogleReplyReader::skipValue()
+{
+    // Skipped data is consumed right away, only quotes and brackets are tracked.
+    // Numbers and literals end before the next separator.
+    const char *data = m_buffer.constData();
+    while (m_pos < m_buffer.size()) {
+        const char c = data[m_pos];
+        if (m_skipInString) {
+            if (m_skipEscape) {
+                m_skipEscape = false;
+            } else if (c == '\\') {
+                m_skipEscape = true;
+            } else if (c == '"') {
+                m_skipInString = false;
+                if (m_skipDepth == 0)
+                    return finishSkip(m_pos + 1);
+            }
+        } else if (c == '"') {
+            m_skipInString = true;
+        } else if (c == '[' || c == '{') {
+            ++m_skipDepth;
+        } else if (c == ']' || c == '}') {
+            if (m_skipDepth == 0)
+                return finishSkip(m_pos);
+            if (--m_skipDepth == 0)
+                return finishSkip(m_pos + 1);
+        } else if (m_skipDepth == 0 && (c == ',' || isWhitespace(c))) {
+            return finishSkip(m_pos);
+        }
+        ++m_pos;
+    }
+
+    return false;
+}
+
+bool QGoogleReplyReader::finishSkip(int end)
+{
+    m_pos = end;
+    m_state = ExpectCommaOrEnd;
+    return true;
+}
+
+void QGoogleReplyReader::closeArray()
+{
+    ++m_pos;
+    --m_depth;
+    m_state = ExpectCommaOrEnd;
+    if (m_depth == 0) {
+        m_state = Finished;
+        return;
+    }
+
+    // Options and examples are collected when their containers are closed
+    switch (m_indexes[0]) {
+    case 1:
+        if (m_depth == 4) {
+            m_options.append(m_option);
+            m_option = {};
+        } else if (m_depth == 2) {
+            if (!m_options.isEmpty())
+                m_translationOptions[m_typeOfSpeech].append(m_options);
+            m_options.clear();
+            m_typeOfSpeech.clear();
+        }
+        break;
+    case 12:
+        if (m_depth == 4) {
+            m_groupExamples.append(m_example);
+            m_example = {};
+        } else if (m_depth == 2) {
+            if (!m_groupExamples.isEmpty())
+                m_examples[m_typeOfSpeech].append(m_groupExamples);
+            m_groupExamples.clear();
+            m_typeOfSpeech.clear();
+        }
+        break;
+    }
+}
+
+bool QGoogleReplyReader::isUsedArray() const
+{
+    /*
+     * Reply is an array with positional fields, only the following are used:
+     * 0: translation parts [[translation, source, ...], ..., [null, null, translation translit, source translit]]
+     * 1: translation options [[type of speech, [words], [[word, [translations], null, score, gender], ...]], ...]
+     * 2: source language
+     * 12: examples [[type of speech, [[definition, null, example], ...]], ...]
+     */
+    switch (m_indexes[0]) {
+    case 0:
+        return m_depth <= 2;
+    case 1:
+        return (m_depth == 1 && m_translationOptionsEnabled) || m_depth == 2 || m_depth == 4
+            || (m_depth == 3 && m_indexes[2] == 2) || (m_depth == 5 && m_indexes[4] == 1);
+    case 12:
+        return (m_depth == 1 && m_examplesEnabled) || m_depth == 2 || m_depth == 4 || (m_depth == 3 && m_indexes[2] == 1);
+    default:
+        return false;
+    }
+}
+
+QGoogleReplyReader::Field QGoogleReplyReader::stringField() const
+{
+    switch (m_indexes[0]) {
+    case 0:
+        if (m_depth != 3)
+            return NoField;
+
+        switch (m_indexes[2]) {
+        case 0:
+            return Translation;
+        case 2:
+            return m_translationTranslitEnabled ? TranslationTranslit : NoField;
+        case 3:
+            return m_sourceTranslitEnabled ? SourceTranslit : NoField;
+        default:
+            return NoField;
+        }
+    case 1:
+        if (m_depth == 3 && m_indexes[2] == 0)
+            return TypeOfSpeech;
+        if (m_depth == 5 && m_indexes[4] == 0)
+            return OptionWord;
+        if (m_depth == 5 && m_indexes[4] == 4)
+            return OptionGender;
+        if (m_depth == 6)
+            return OptionTranslation;
+        return NoField;
+    case 2:
+        return m_depth == 1 ? SourceLanguage : NoField;
+    case 12:
+        if (m_depth == 3 && m_indexes[2] == 0)
+            return TypeOfSpeech;
+        if (m_depth == 5 && m_indexes[4] == 0)
+            return ExampleDescription;
+        if (m_depth == 5 && m_indexes[4] == 2)
+            return Example;
+        return NoField;
+    default:
+        return NoField;
+    }
+}
+
+void QGoogleReplyReader::setError()
+{
+    m_state = Failed;
+}
@@ -0,0 +1,208 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef QGOOGLEREPLYREADER_H
+#define QGOOGLEREPLYREADER_H
+
+#include "qexample.h"
+#include "qoption.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <QVector>
+
+#include <array>
+
+/**
+ * @brief Reads replies of Google translate_a/single while they are received
+ *
+ * Walks the positional arrays of the reply directly on its bytes.
+ * Values that are not used are skipped by matching brackets and quotes without tokenizing them,
+ * only the used strings are decoded.
+ * Not a part of the public API, used by the library and its benchmarks.
+ */
+class QGoogleReplyReader
+{
+public:
+    /**
+     * @brief Add data and read it
+     *
+     * Reading stops at an incomplete value and continues when the next chunk is added.
+     *
+     * @param data next chunk of the reply
+     */
+    void addData(const QByteArray &data);
+
+    /**
+     * @brief Check if the whole reply was read
+     *
+     * @return `true` if the reply was read
+     */
+    bool atEnd() const;
+
+    /**
+     * @brief Check if the reply is not well formed
+     *
+     * @return `true` if the reply is not a JSON array
+     */
+    bool hasError() const;
+
+    /**
+     * @brief Enable or disable reading of translation transliteration
+     *
+     * @param enable whether to read it
+     */
+    void setTranslationTranslitEnabled(bool enable);
+
+    /**
+     * @brief Enable or disable reading of source transliteration
+     *
+     * @param enable whether to read it
+     */
+    void setSourceTranslitEnabled(bool enable);
+
+    /**
+     * @brief Enable or disable reading of translation options
+     *
+     * @param enable whether to read them
+     */
+    void setTranslationOptionsEnabled(bool enable);
+
+    /**
+     * @brief Enable or disable reading of examples
+     *
+     * @param enable whether to read them
+     */
+    void setExamplesEnabled(bool enable);
+
+    /**
+     * @brief Translation
+     *
+     * @return joined translation parts
+     */
+    const QString &translation() const;
+
+    /**
+     * @brief Translation transliteration
+     *
+     * @return transliteration of the translation
+     */
+    const QString &translationTranslit() const;
+
+    /**
+     * @brief Source transliteration
+     *
+     * @return transliteration of the source
+     */
+    const QString &sourceTranslit() const;
+
+    /**
+     * @brief Language code of the source
+     *
+     * @return code of the detected or the requested source language
+     */
+    const QString &sourceLanguageCode() const;
+
+    /**
+     * @brief Translation options
+     *
+     * @return options grouped by type of speech
+     */
+    const QMap<QString, QVector<QOption>> &translationOptions() const;
+
+    /**
+     * @brief Examples
+     *
+     * @return examples grouped by type of speech
+     */
+    const QMap<QString, QVector<QExample>> &examples() const;
+
+private:
+    enum State {
+        ExpectDocument,
+        ExpectValue,
+        ExpectValueOrEnd,
+        ExpectCommaOrEnd,
+        SkipValue,
+        Finished,
+        Failed
+    };
+
+    // Fields of the reply, addressed by the indexes of their containers
+    enum Field {
+        NoField,
+        Translation,
+        TranslationTranslit,
+        SourceTranslit,
+        SourceLanguage,
+        TypeOfSpeech,
+        OptionWord,
+        OptionGender,
+        OptionTranslation,
+        ExampleDescription,
+        Example
+    };
+
+    static constexpr int s_maxDepth = 6; // Deepest read container is a list of option translations
+
+    bool readValue(char c);
+    bool readString(Field field);
+    bool skipValue();
+    bool finishSkip(int end);
+    void closeArray();
+    bool isUsedArray() const;
+    Field stringField() const;
+    void setError();
+
+    QByteArray m_buffer; // Unread data, read data is removed when a new chunk is added
+    int m_pos = 0;
+    int m_scanned = 0; // Already checked bytes of the incomplete string
+    bool m_escaped = false;
+
+    // Indexes of values in the opened arrays
+    std::array<int, s_maxDepth> m_indexes{};
+    int m_depth = 0;
+
+    // Skipped value
+    int m_skipDepth = 0;
+    bool m_skipInString = false;
+    bool m_skipEscape = false;
+
+    State m_state = ExpectDocument;
+    bool m_translationTranslitEnabled = false;
+    bool m_sourceTranslitEnabled = false;
+    bool m_translationOptionsEnabled = false;
+    bool m_examplesEnabled = false;
+
+    QString m_translation;
+    QString m_translationTranslit;
+    QString m_sourceTranslit;
+    QString m_sourceLanguageCode;
+    QMap<QString, QVector<QOption>> m_translationOptions;
+    QMap<QString, QVector<QExample>> m_examples;
+
+    // Dictionary group that is being read
+    QString m_typeOfSpeech;
+    QVector<QOption> m_options;
+    QVector<QExample> m_groupExamples;
+    QOption m_option;
+    QExample m_example;
+};
+
+#endif // QGOOGLEREPLYREADER_H
@@ -0,0 +1,369 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "qjsonstreamreader.h"
+
+#include <cstring>
+
+namespace
+{
+bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isNumberCharacter(char c)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+}
+
+void QJsonStreamReader::addData(const QByteArray &data)
+{
+    m_buffer += data;
+}
+
+void QJsonStreamReader::clear()
+{
+    *this = QJsonStreamReader();
+}
+
+bool QJsonStreamReader::readNext()
+{
+    if (m_state == Failed)
+        return false;
+
+    // Remove read data when it takes the most of the buffer, the current token is no longer needed
+    if (m_pos != 0 && m_pos * 2 >= m_buffer.size()) {
+        m_buffer.remove(0, m_pos);
+        m_pos = 0;
+    }
+    m_tokenType = NoToken;
+
+    if (m_skipDepth != 0)
+        return skipElement();
+
+    forever {
+        while (m_pos < m_buffer.size() && isWhitespace(m_buffer.at(m_pos)))
+            ++m_pos;
+
+        if (m_pos == m_buffer.size())
+            return false;
+
+        const char c = m_buffer.at(m_pos);
+        switch (m_state) {
+        case ExpectValue:
+            return readValue(c);
+        case ExpectValueOrEnd:
+            if (c == ']')
+                return readEnd(c);
+            return readValue(c);
+        case ExpectKeyOrEnd:
+            if (c == '}')
+                return readEnd(c);
+            Q_FALLTHROUGH();
+        case ExpectKey: {
+            if (c != '"')
+                return setError();
+
+            int size;
+            if (!scanString(size))
+                return false;
+
+            m_levels.last().key = m_buffer.mid(m_pos + 1, size - 2);
+            m_pos += size;
+            m_state = ExpectColon;
+            break;
+        }
+        case ExpectColon:
+            if (c != ':')
+                return setError();
+
+            ++m_pos;
+            m_state = ExpectValue;
+            break;
+        case ExpectCommaOrEnd:
+            if (c != ',')
+                return readEnd(c);
+
+            ++m_pos;
+            ++m_levels.last().index;
+            m_state = m_levels.last().object ? ExpectKey : ExpectValue;
+            break;
+        case Finished:
+        case Failed:
+            // Only whitespaces are allowed after the document
+            return setError();
+        }
+    }
+}
+
+void QJsonStreamReader::skipCurrentElement()
+{
+    if (m_tokenType == StartArray || m_tokenType == StartObject)
+        m_skipDepth = 1;
+}
+
+QJsonStreamReader::TokenType QJsonStreamReader::tokenType() const
+{
+    return m_tokenType;
+}
+
+int QJsonStreamReader::depth() const
+{
+    return m_tokenDepth;
+}
+
+int QJsonStreamReader::index(int level) const
+{
+    return m_levels.at(level).index;
+}
+
+QLatin1String QJsonStreamReader::key(int level) const
+{
+    const QByteArray &key = m_levels.at(level).key;
+    return QLatin1String(key.constData(), key.size());
+}
+
+QString QJsonStreamReader::text() const
+{
+    const char *data = m_buffer.constData() + m_tokenBegin;
+    if (!m_escaped)
+        return QString::fromUtf8(data, m_tokenSize);
+
+    // Escape sequences are ASCII, so they do not split UTF-8 sequences between them
+    QString text;
+    text.reserve(m_tokenSize);
+    int chunkBegin = 0;
+    for (int i = 0; i < m_tokenSize; ++i) {
+        if (data[i] != '\\')
+            continue;
+
+        text += QString::fromUtf8(data + chunkBegin, i - chunkBegin);
+        switch (data[++i]) {
+        case 'b':
+            text += QLatin1Char('\b');
+            break;
+        case 'f':
+            text += QLatin1Char('\f');
+            break;
+        case 'n':
+            text += QLatin1Char('\n');
+            break;
+        case 'r':
+            text += QLatin1Char('\r');
+            break;
+        case 't':
+            text += QLatin1Char('\t');
+            break;
+        case 'u':
+            // Surrogate pairs are written as two escape sequences, so each one is a single UTF-16 code unit
+            if (i + 4 < m_tokenSize) {
+                bool ok;
+                const ushort unicode = QByteArray::fromRawData(data + i + 1, 4).toUShort(&ok, 16);
+                if (ok)
+                    text += QChar(unicode);
+                i += 4;
+            }
+            break;
+        default:
+            text += QLatin1Char(data[i]);
+        }
+        chunkBegin = i + 1;
+    }
+    text += QString::fromUtf8(data + chunkBegin, m_tokenSize - chunkBegin);
+
+    return text;
+}
+
+double QJsonStreamReader::number() const
+{
+    return QByteArray::fromRawData(m_buffer.constData() + m_tokenBegin, m_tokenSize).toDouble();
+}
+
+bool QJsonStreamReader::boolean() const
+{
+    return m_tokenType == Bool && m_buffer.at(m_tokenBegin) == 't';
+}
+
+bool QJsonStreamReader::atEnd() const
+{
+    return m_state == Finished;
+}
+
+bool QJsonStreamReader::hasError() const
+{
+    return m_state == Failed;
+}
+
+bool QJsonStreamReader::readValue(char c)
+{
+    switch (c) {
+    case '[':
+    case '{':
+        ++m_pos;
+        setToken(c == '[' ? StartArray : StartObject, m_pos, 0);
+        m_levels.append({c == '{', 0, {}});
+        m_state = c == '[' ? ExpectValueOrEnd : ExpectKeyOrEnd;
+        return true;
+    case '"': {
+        int size;
+        if (!scanString(size))
+            return false;
+
+        setToken(String, m_pos + 1, size - 2);
+        m_pos += size;
+        finishValue();
+        return true;
+    }
+    case 't':
+        return readLiteral("true", Bool);
+    case 'f':
+        return readLiteral("false", Bool);
+    case 'n':
+        return readLiteral("null", Null);
+    default:
+        if (c == '-' || (c >= '0' && c <= '9'))
+            return readNumber();
+        return setError();
+    }
+}
+
+bool QJsonStreamReader::readEnd(char c)
+{
+    if (m_levels.isEmpty() || c != (m_levels.last().object ? '}' : ']'))
+        return setError();
+
+    ++m_pos;
+    m_levels.removeLast();
+    setToken(c == ']' ? EndArray : EndObject, m_pos, 0);
+    finishValue();
+    return true;
+}
+
+bool QJsonStreamReader::readLiteral(const char *literal, TokenType type)
+{
+    const int size = static_cast<int>(std::strlen(literal));
+    const int available = qMin(size, m_buffer.size() - m_pos);
+    if (std::memcmp(m_buffer.constData() + m_pos, literal, available) != 0)
+        return setError();
+
+    if (available != size)
+        return false;
+
+    setToken(type, m_pos, size);
+    m_pos += size;
+    finishValue();
+    return true;
+}
+
+bool QJsonStreamReader::readNumber()
+{
+    // Number is complete only when a character after it is received
+    int end = m_pos + 1;
+    while (end < m_buffer.size() && isNumberCharacter(m_buffer.at(end)))
+        ++end;
+
+    if (end == m_buffer.size())
+        return false;
+
+    setToken(Number, m_pos, end - m_pos);
+    m_pos = end;
+    finishValue();
+    return true;
+}
+
+bool QJsonStreamReader::scanString(int &size)
+{
+    // Continue from the place where the previous call stopped
+    if (m_scanned == 0)
+        m_escaped = false;
+
+    const char *data = m_buffer.constData();
+    int i = m_pos + 1 + m_scanned;
+    while (i < m_buffer.size()) {
+        if (data[i] == '"') {
+            size = i + 1 - m_pos;
+            m_scanned = 0;
+            return true;
+        }
+
+        if (data[i] == '\\') {
+            if (i + 1 == m_buffer.size())
+                break;
+            m_escaped = true;
+            i += 2;
+        } else {
+            ++i;
+        }
+    }
+
+    m_scanned = i - m_pos - 1;
+    return false;
+}
+
+bool QJsonStreamReader::skipElement()
+{
+    // Skipped data is not needed, so it is consumed right away
+    const char *data = m_buffer.constData();
+    while (m_pos < m_buffer.size()) {
+        const char c = data[m_pos];
+        if (m_skipInString) {
+            if (m_skipEscape)
+                m_skipEscape = false;
+            else if (c == '\\')
+                m_skipEscape = true;
+            else if (c == '"')
+                m_skipInString = false;
+        } else if (c == '"') {
+            m_skipInString = true;
+        } else if (c == '[' || c == '{') {
+            ++m_skipDepth;
+        } else if ((c == ']' || c == '}') && --m_skipDepth == 0) {
+            return readEnd(c);
+        }
+        ++m_pos;
+    }
+
+    return false;
+}
+
+void QJsonStreamReader::finishValue()
+{
+    m_state = m_levels.isEmpty() ? Finished : ExpectCommaOrEnd;
+}
+
+void QJsonStreamReader::setToken(TokenType type, int begin, int size)
+{
+    m_tokenType = type;
+    m_tokenDepth = m_levels.size();
+    m_tokenBegin = begin;
+    m_tokenSize = size;
+
+    // Set by scanString() for the current string or a key before the value
+    if (type != String)
+        m_escaped = false;
+}
+
+bool QJsonStreamReader::setError()
+{
+    m_state = Failed;
+    m_tokenType = Invalid;
+    return false;
+}
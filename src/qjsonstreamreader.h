@@ -0,0 +1,209 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef QJSONSTREAMREADER_H
+#define QJSONSTREAMREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Provides incremental reading of JSON
+ *
+ * Reads JSON that is added in chunks, similar to QXmlStreamReader, without building a document.
+ * Tokens are available as soon as their bytes are added, strings are decoded only when requested
+ * and containers can be skipped without reading their tokens.
+ *
+ * Used by QOnlineTranslator to parse replies while they are received.
+ *
+ * Example:
+ * @code
+ * QJsonStreamReader reader;
+ * connect(reply, &QNetworkReply::readyRead, [&reader, reply] {
+ *     reader.addData(reply->readAll());
+ *     while (reader.readNext()) {
+ *         if (reader.tokenType() == QJsonStreamReader::String && reader.depth() == 1 && reader.key(0) == QLatin1String("translation"))
+ *             qDebug() << reader.text();
+ *     }
+ * });
+ * @endcode
+ */
+class QJsonStreamReader
+{
+public:
+    /**
+     * @brief Token type
+     */
+    enum TokenType {
+        NoToken,
+        Invalid,
+        StartArray,
+        EndArray,
+        StartObject,
+        EndObject,
+        String,
+        Number,
+        Bool,
+        Null
+    };
+
+    /**
+     * @brief Add data
+     *
+     * @param data next chunk of the document
+     */
+    void addData(const QByteArray &data);
+
+    /**
+     * @brief Reset reader to read a new document
+     */
+    void clear();
+
+    /**
+     * @brief Read the next token
+     *
+     * @return `true` if a token was read, `false` if more data is needed, the document was read or it is not well formed
+     */
+    bool readNext();
+
+    /**
+     * @brief Skip the current container
+     *
+     * Can be called after reading StartArray or StartObject token.
+     * The next readNext() call will read the corresponding end token, ignoring all tokens inside the container.
+     */
+    void skipCurrentElement();
+
+    /**
+     * @brief Type of the current token
+     *
+     * @return type of the current token
+     */
+    TokenType tokenType() const;
+
+    /**
+     * @brief Number of containers around the current token
+     *
+     * For start and end tokens the container itself is not counted.
+     *
+     * @return depth of the current token
+     */
+    int depth() const;
+
+    /**
+     * @brief Position of the current token in the container at the level
+     *
+     * @param level from 0 to depth() - 1, where the last level is the container of the current token
+     * @return index of the element inside the container at the level
+     */
+    int index(int level) const;
+
+    /**
+     * @brief Key of the current token in the object at the level
+     *
+     * Escape sequences are not decoded, the returned string is valid until the next readNext() call.
+     *
+     * @param level from 0 to depth() - 1, where the last level is the container of the current token
+     * @return key of the member inside the object at the level, empty string for arrays
+     */
+    QLatin1String key(int level) const;
+
+    /**
+     * @brief Value of the current token
+     *
+     * @return decoded string for String token, the literal for other value tokens
+     */
+    QString text() const;
+
+    /**
+     * @brief Numeric value of the current token
+     *
+     * @return number for Number token
+     */
+    double number() const;
+
+    /**
+     * @brief Boolean value of the current token
+     *
+     * @return value of Bool token
+     */
+    bool boolean() const;
+
+    /**
+     * @brief Check if the whole document was read
+     *
+     * @return `true` if the document was read
+     */
+    bool atEnd() const;
+
+    /**
+     * @brief Check if the document is not well formed
+     *
+     * @return `true` if the document is not well formed
+     */
+    bool hasError() const;
+
+private:
+    enum State {
+        ExpectValue,
+        ExpectValueOrEnd,
+        ExpectKey,
+        ExpectKeyOrEnd,
+        ExpectColon,
+        ExpectCommaOrEnd,
+        Finished,
+        Failed
+    };
+
+    struct Level {
+        bool object;
+        int index;
+        QByteArray key;
+    };
+
+    bool readValue(char c);
+    bool readEnd(char c);
+    bool readLiteral(const char *literal, TokenType type);
+    bool readNumber();
+    bool scanString(int &size);
+    bool skipElement();
+    void finishValue();
+    void setToken(TokenType type, int begin, int size);
+    bool setError();
+
+    QByteArray m_buffer; // Unread data, read data is removed when the buffer grows
+    QVector<Level> m_levels;
+    int m_pos = 0;
+    int m_scanned = 0; // Already checked bytes of the incomplete string
+
+    // Skipped container
+    int m_skipDepth = 0;
+    bool m_skipInString = false;
+    bool m_skipEscape = false;
+
+    State m_state = ExpectValue;
+    TokenType m_tokenType = NoToken;
+    int m_tokenDepth = 0;
+    int m_tokenBegin = 0;
+    int m_tokenSize = 0;
+    bool m_escaped = false;
+};
+
+#endif // QJSONSTREAMREADER_H
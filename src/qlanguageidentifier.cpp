@@ -0,0 +1,308 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "qlanguageidentifier.h"
+
+#include <QSaveFile>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+constexpr quint32 s_modelMagic = 0x514C4944; // "QLID"
+constexpr quint32 s_modelVersion = 1;
+constexpr int s_maxNgramSize = 3;
+constexpr int s_maxTextSize = 4096; // Longer texts do not improve accuracy
+constexpr quint32 s_laneCount = 8; // Weights of a bucket are padded to a multiple of it for vectorized addition
+constexpr qreal s_weightScale = 64; // Weights are natural logarithms of n-gram probabilities in fixed point
+
+// Model file consists of the header, qint32 languages[stride] and qint16 weights[bucketCount][stride].
+// Weights of all languages for a bucket are stored together, so each n-gram adds one contiguous row.
+struct ModelHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 bucketCount; // Power of two
+    quint32 languageCount;
+    quint32 stride; // Languages and weights per bucket, padding languages are NoLanguage
+    quint32 reserved[3];
+};
+
+quint64 modelSize(quint64 bucketCount, quint64 stride)
+{
+    return sizeof(ModelHeader) + stride * sizeof(qint32) + bucketCount * stride * sizeof(qint16);
+}
+
+const ModelHeader *modelHeader(const uchar *model)
+{
+    return reinterpret_cast<const ModelHeader *>(model);
+}
+
+const qint32 *modelLanguages(const uchar *model)
+{
+    return reinterpret_cast<const qint32 *>(model + sizeof(ModelHeader));
+}
+
+const qint16 *modelWeights(const uchar *model)
+{
+    return reinterpret_cast<const qint16 *>(model + sizeof(ModelHeader) + modelHeader(model)->stride * sizeof(qint32));
+}
+
+bool isPowerOfTwo(quint64 value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+bool isValidModel(const uchar *model, qint64 size)
+{
+    if (static_cast<quint64>(size) < sizeof(ModelHeader))
+        return false;
+
+    const ModelHeader *header = modelHeader(model);
+    if (header->magic != s_modelMagic || header->version != s_modelVersion)
+        return false;
+
+    if (!isPowerOfTwo(header->bucketCount) || header->languageCount == 0 || header->stride < header->languageCount || header->stride % s_laneCount != 0)
+        return false;
+
+    if (static_cast<quint64>(size) != modelSize(header->bucketCount, header->stride))
+        return false;
+
+    const qint32 *languages = modelLanguages(model);
+    for (quint32 i = 0; i < header->languageCount; ++i) {
+        if (languages[i] <= QOnlineTranslator::Auto || languages[i] > QOnlineTranslator::Zulu)
+            return false;
+    }
+
+    return true;
+}
+
+// Calls the function with hashes of character n-grams of the text.
+// Letters are lowercased, other characters separate words and each word is surrounded by spaces.
+template<typename Function>
+void forEachNgram(const QChar *text, int size, Function function)
+{
+    uint window[s_maxNgramSize] = {}; // The last characters, the latest is first
+    int windowSize = 0;
+    const auto append = [&](uint character) {
+        for (int i = s_maxNgramSize - 1; i > 0; --i)
+            window[i] = window[i - 1];
+        window[0] = character;
+        windowSize = qMin(windowSize + 1, s_maxNgramSize);
+
+        // FNV-1a of n-grams that end with the character, extended backwards
+        quint32 hash = 2166136261U;
+        for (int i = 0; i < windowSize; ++i) {
+            hash = (hash ^ window[i]) * 16777619U;
+            if (i != 0 || character != ' ')
+                function(hash);
+        }
+    };
+
+    append(' ');
+    bool separated = true;
+    for (int i = 0; i < size; ++i) {
+        uint ucs4 = text[i].unicode();
+        if (text[i].isHighSurrogate() && i + 1 < size && text[i + 1].isLowSurrogate())
+            ucs4 = QChar::surrogateToUcs4(text[i], text[++i]);
+
+        if (QChar::isLetter(ucs4) || QChar::isMark(ucs4)) {
+            append(QChar::toLower(ucs4));
+            separated = false;
+        } else if (!separated) {
+            append(' ');
+            separated = true;
+        }
+    }
+    if (!separated)
+        append(' ');
+}
+
+// Adds weights of all languages for one n-gram.
+// Kept as a plain loop over padded lanes, so compilers turn it into SIMD additions for the target.
+void addWeights(qint32 *scores, const qint16 *weights, quint32 stride)
+{
+    for (quint32 i = 0; i < stride; i += s_laneCount) {
+        for (quint32 lane = 0; lane < s_laneCount; ++lane)
+            scores[i + lane] += weights[i + lane];
+    }
+}
+}
+
+QLanguageIdentifier::QLanguageIdentifier() = default;
+
+QLanguageIdentifier::~QLanguageIdentifier()
+{
+    unload();
+}
+
+bool QLanguageIdentifier::load(const QString &fileName)
+{
+    unload();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    m_model = m_file.map(0, m_file.size());
+    if (m_model == nullptr || !isValidModel(m_model, m_file.size())) {
+        unload();
+        return false;
+    }
+
+    return true;
+}
+
+void QLanguageIdentifier::unload()
+{
+    if (m_model != nullptr) {
+        m_file.unmap(m_model);
+        m_model = nullptr;
+    }
+    m_file.close();
+}
+
+bool QLanguageIdentifier::isLoaded() const
+{
+    return m_model != nullptr;
+}
+
+QList<QOnlineTranslator::Language> QLanguageIdentifier::languages() const
+{
+    QList<QOnlineTranslator::Language> languages;
+    if (m_model == nullptr)
+        return languages;
+
+    const qint32 *modelLangs = modelLanguages(m_model);
+    for (quint32 i = 0; i < modelHeader(m_model)->languageCount; ++i)
+        languages.append(static_cast<QOnlineTranslator::Language>(modelLangs[i]));
+
+    return languages;
+}
+
+qreal QLanguageIdentifier::minConfidence() const
+{
+    return m_minConfidence;
+}
+
+void QLanguageIdentifier::setMinConfidence(qreal confidence)
+{
+    m_minConfidence = confidence;
+}
+
+QOnlineTranslator::Language QLanguageIdentifier::identify(const QString &text, qreal *confidence) const
+{
+    if (confidence != nullptr)
+        *confidence = 0;
+
+    if (m_model == nullptr)
+        return QOnlineTranslator::NoLanguage;
+
+    const ModelHeader *header = modelHeader(m_model);
+    const qint16 *weights = modelWeights(m_model);
+    const quint32 bucketMask = header->bucketCount - 1;
+
+    // Scores are sums of log probabilities of n-grams for each language
+    QVarLengthArray<qint32, 256> scores(static_cast<int>(header->stride));
+    std::fill(scores.begin(), scores.end(), 0);
+    int ngramCount = 0;
+    forEachNgram(text.constData(), qMin(text.size(), s_maxTextSize), [&](quint32 hash) {
+        addWeights(scores.data(), weights + static_cast<quint64>(hash & bucketMask) * header->stride, header->stride);
+        ++ngramCount;
+    });
+
+    if (ngramCount == 0)
+        return QOnlineTranslator::NoLanguage;
+
+    quint32 bestLane = 0;
+    qint64 secondScore = std::numeric_limits<qint64>::min();
+    for (quint32 i = 1; i < header->languageCount; ++i) {
+        if (scores[i] > scores[bestLane]) {
+            secondScore = scores[bestLane];
+            bestLane = i;
+        } else if (scores[i] > secondScore) {
+            secondScore = scores[i];
+        }
+    }
+
+    // Probability that the best language is more likely than the next one
+    qreal bestConfidence = 1;
+    if (header->languageCount > 1)
+        bestConfidence = 1 / (1 + std::exp((secondScore - scores[bestLane]) / s_weightScale));
+
+    if (confidence != nullptr)
+        *confidence = bestConfidence;
+
+    if (bestConfidence < m_minConfidence)
+        return QOnlineTranslator::NoLanguage;
+
+    return static_cast<QOnlineTranslator::Language>(modelLanguages(m_model)[bestLane]);
+}
+
+bool QLanguageIdentifier::createModel(const QString &fileName, const QMap<QOnlineTranslator::Language, QString> &samples, int bucketCount)
+{
+    if (samples.isEmpty() || !isPowerOfTwo(static_cast<quint64>(qMax(bucketCount, 0))))
+        return false;
+
+    const auto languageCount = static_cast<quint32>(samples.size());
+    const quint32 stride = (languageCount + s_laneCount - 1) / s_laneCount * s_laneCount;
+    const quint64 size = modelSize(static_cast<quint64>(bucketCount), stride);
+    if (size > static_cast<quint64>(std::numeric_limits<int>::max()))
+        return false;
+
+    QByteArray model(static_cast<int>(size), '\0');
+    auto *header = reinterpret_cast<ModelHeader *>(model.data());
+    *header = {s_modelMagic, s_modelVersion, static_cast<quint32>(bucketCount), languageCount, stride, {}};
+
+    auto *languages = reinterpret_cast<qint32 *>(model.data() + sizeof(ModelHeader));
+    auto *weights = reinterpret_cast<qint16 *>(model.data() + sizeof(ModelHeader) + stride * sizeof(qint32));
+    std::fill(languages, languages + stride, QOnlineTranslator::NoLanguage);
+
+    const quint32 bucketMask = static_cast<quint32>(bucketCount) - 1;
+    QVector<quint32> counts(bucketCount);
+    quint32 lane = 0;
+    for (auto it = samples.cbegin(); it != samples.cend(); ++it, ++lane) {
+        if (it.key() <= QOnlineTranslator::Auto || it.key() > QOnlineTranslator::Zulu)
+            return false;
+
+        languages[lane] = it.key();
+
+        counts.fill(0);
+        quint64 total = 0;
+        forEachNgram(it.value().constData(), it.value().size(), [&](quint32 hash) {
+            ++counts[static_cast<int>(hash & bucketMask)];
+            ++total;
+        });
+
+        // Add one to each bucket, so n-grams that are missing in samples do not exclude the language
+        for (int bucket = 0; bucket < bucketCount; ++bucket) {
+            const qreal logProbability = std::log((counts.at(bucket) + 1.0) / static_cast<qreal>(total + static_cast<quint64>(bucketCount)));
+            const qreal weight = qMax<qreal>(std::round(logProbability * s_weightScale), std::numeric_limits<qint16>::min());
+            weights[static_cast<quint64>(bucket) * stride + lane] = static_cast<qint16>(weight);
+        }
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(model) != model.size())
+        return false;
+
+    return file.commit();
+}
@@ -0,0 +1,132 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef QLANGUAGEIDENTIFIER_H
+#define QLANGUAGEIDENTIFIER_H
+
+#include "qonlinetranslator.h"
+
+#include <QFile>
+
+/**
+ * @brief Provides local language identification
+ *
+ * Identifies language of a text by its character n-grams without network requests.
+ * Language profiles are loaded from a model file that is memory-mapped,
+ * so it is shared between processes and only the used parts are read from disk.
+ * Models can be created from sample texts with createModel().
+ *
+ * Example:
+ * @code
+ * QLanguageIdentifier identifier;
+ * identifier.load("languages.qlid");
+ *
+ * QOnlineTranslator translator;
+ * translator.setLanguageIdentifier(&identifier);
+ * translator.detectLanguage("¿Dónde está la biblioteca?"); // Finishes without requests
+ * @endcode
+ */
+class QLanguageIdentifier
+{
+    Q_DISABLE_COPY(QLanguageIdentifier)
+
+public:
+    /**
+     * @brief Create identifier without model
+     */
+    QLanguageIdentifier();
+
+    /**
+     * @brief Destroy identifier
+     *
+     * Unmaps the model, if any.
+     */
+    ~QLanguageIdentifier();
+
+    /**
+     * @brief Load model
+     *
+     * @param fileName path to the model file
+     * @return `true` if the model was successfully loaded
+     */
+    bool load(const QString &fileName);
+
+    /**
+     * @brief Unload model
+     */
+    void unload();
+
+    /**
+     * @brief Check if a model is loaded
+     *
+     * @return `true` if a model is loaded
+     */
+    bool isLoaded() const;
+
+    /**
+     * @brief Languages of the loaded model
+     *
+     * @return languages that can be identified
+     */
+    QList<QOnlineTranslator::Language> languages() const;
+
+    /**
+     * @brief Minimum confidence
+     *
+     * @return minimum confidence of identified languages
+     */
+    qreal minConfidence() const;
+
+    /**
+     * @brief Set minimum confidence
+     *
+     * Languages with lower confidence are not returned by identify().
+     *
+     * @param confidence probability from 0 to 1 that the identified language is more likely than the next one
+     */
+    void setMinConfidence(qreal confidence);
+
+    /**
+     * @brief Identify language
+     *
+     * Thread-safe.
+     *
+     * @param text text to identify
+     * @param confidence if not `nullptr`, receives confidence of the identified language
+     * @return identified language or QOnlineTranslator::NoLanguage if the model is not loaded or the confidence is too low
+     */
+    QOnlineTranslator::Language identify(const QString &text, qreal *confidence = nullptr) const;
+
+    /**
+     * @brief Create model from samples
+     *
+     * @param fileName path to the model file
+     * @param samples texts for each language, larger texts give better accuracy
+     * @param bucketCount number of hashed n-gram buckets, should be a power of two
+     * @return `true` if the model was successfully created
+     */
+    static bool createModel(const QString &fileName, const QMap<QOnlineTranslator::Language, QString> &samples, int bucketCount = 1 << 16);
+
+private:
+    QFile m_file;
+    uchar *m_model = nullptr; // Mapped model file, see qlanguageidentifier.cpp for the layout
+    qreal m_minConfidence = 0.95;
+};
+
+#endif // QLANGUAGEIDENTIFIER_H
@@ -19,177 +19,534 @@
 
 #include "qonlinetranslator.h"
 
+#include "qenginecapabilities.h"
+#include "qgooglereplyreader.h"
+#include "qjsonstreamreader.h"
+#include "qlanguageidentifier.h"
 #include "qonlinetts.h"
+#include "qtextsplitter.h"
+#include "qtranslationcache.h"
+#include "qtransliterator.h"
 
 #include <QCoreApplication>
-#include <QFinalState>
+#include <QDateTime>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMediaPlayer>
 #include <QNetworkReply>
-#include <QStateMachine>
-
-const QMap<QOnlineTranslator::Language, QString> QOnlineTranslator::s_genericLanguageCodes = {
-    {Auto, QStringLiteral("auto")},
-    {Afrikaans, QStringLiteral("af")},
-    {Albanian, QStringLiteral("sq")},
-    {Amharic, QStringLiteral("am")},
-    {Arabic, QStringLiteral("ar")},
-    {Armenian, QStringLiteral("hy")},
-    {Azerbaijani, QStringLiteral("az")},
-    {Bashkir, QStringLiteral("ba")},
-    {Basque, QStringLiteral("eu")},
-    {Belarusian, QStringLiteral("be")},
-    {Bengali, QStringLiteral("bn")},
-    {Bosnian, QStringLiteral("bs")},
-    {Bulgarian, QStringLiteral("bg")},
-    {Cantonese, QStringLiteral("yue")},
-    {Catalan, QStringLiteral("ca")},
-    {Cebuano, QStringLiteral("ceb")},
-    {Chichewa, QStringLiteral("ny")},
-    {Corsican, QStringLiteral("co")},
-    {Croatian, QStringLiteral("hr")},
-    {Czech, QStringLiteral("cs")},
-    {Danish, QStringLiteral("da")},
-    {Dutch, QStringLiteral("nl")},
-    {English, QStringLiteral("en")},
-    {Esperanto, QStringLiteral("eo")},
-    {Estonian, QStringLiteral("et")},
-    {Fijian, QStringLiteral("fj")},
-    {Filipino, QStringLiteral("fil")},
-    {Finnish, QStringLiteral("fi")},
-    {French, QStringLiteral("fr")},
-    {Frisian, QStringLiteral("fy")},
-    {Galician, QStringLiteral("gl")},
-    {Georgian, QStringLiteral("ka")},
-    {German, QStringLiteral("de")},
-    {Greek, QStringLiteral("el")},
-    {Gujarati, QStringLiteral("gu")},
-    {HaitianCreole, QStringLiteral("ht")},
-    {Hausa, QStringLiteral("ha")},
-    {Hawaiian, QStringLiteral("haw")},
-    {Hebrew, QStringLiteral("he")},
-    {HillMari, QStringLiteral("mrj")},
-    {Hindi, QStringLiteral("hi")},
-    {Hmong, QStringLiteral("hmn")},
-    {Hungarian, QStringLiteral("hu")},
-    {Icelandic, QStringLiteral("is")},
-    {Igbo, QStringLiteral("ig")},
-    {Indonesian, QStringLiteral("id")},
-    {Irish, QStringLiteral("ga")},
-    {Italian, QStringLiteral("it")},
-    {Japanese, QStringLiteral("ja")},
-    {Javanese, QStringLiteral("jw")},
-    {Kannada, QStringLiteral("kn")},
-    {Kazakh, QStringLiteral("kk")},
-    {Khmer, QStringLiteral("km")},
-    {Kinyarwanda, QStringLiteral("rw")},
-    {Klingon, QStringLiteral("tlh")},
-    {KlingonPlqaD, QStringLiteral("tlh-Qaak")},
-    {Korean, QStringLiteral("ko")},
-    {Kurdish, QStringLiteral("ku")},
-    {Kyrgyz, QStringLiteral("ky")},
-    {Lao, QStringLiteral("lo")},
-    {Latin, QStringLiteral("la")},
-    {Latvian, QStringLiteral("lv")},
-    {LevantineArabic, QStringLiteral("apc")},
-    {Lithuanian, QStringLiteral("lt")},
-    {Luxembourgish, QStringLiteral("lb")},
-    {Macedonian, QStringLiteral("mk")},
-    {Malagasy, QStringLiteral("mg")},
-    {Malay, QStringLiteral("ms")},
-    {Malayalam, QStringLiteral("ml")},
-    {Maltese, QStringLiteral("mt")},
-    {Maori, QStringLiteral("mi")},
-    {Marathi, QStringLiteral("mr")},
-    {Mari, QStringLiteral("mhr")},
-    {Mongolian, QStringLiteral("mn")},
-    {Myanmar, QStringLiteral("my")},
-    {Nepali, QStringLiteral("ne")},
-    {Norwegian, QStringLiteral("no")},
-    {Oriya, QStringLiteral("or")},
-    {Papiamento, QStringLiteral("pap")},
-    {Pashto, QStringLiteral("ps")},
-    {Persian, QStringLiteral("fa")},
-    {Polish, QStringLiteral("pl")},
-    {Portuguese, QStringLiteral("pt")},
-    {Punjabi, QStringLiteral("pa")},
-    {QueretaroOtomi, QStringLiteral("otq")},
-    {Romanian, QStringLiteral("ro")},
-    {Russian, QStringLiteral("ru")},
-    {Samoan, QStringLiteral("sm")},
-    {ScotsGaelic, QStringLiteral("gd")},
-    {SerbianCyrillic, QStringLiteral("sr")},
-    {SerbianLatin, QStringLiteral("sr-Latin")},
-    {Sesotho, QStringLiteral("st")},
-    {Shona, QStringLiteral("sn")},
-    {SimplifiedChinese, QStringLiteral("zh-CN")},
-    {Sindhi, QStringLiteral("sd")},
-    {Sinhala, QStringLiteral("si")},
-    {Slovak, QStringLiteral("sk")},
-    {Slovenian, QStringLiteral("sl")},
-    {Somali, QStringLiteral("so")},
-    {Spanish, QStringLiteral("es")},
-    {Sundanese, QStringLiteral("su")},
-    {Swahili, QStringLiteral("sw")},
-    {Swedish, QStringLiteral("sv")},
-    {Tagalog, QStringLiteral("tl")},
-    {Tahitian, QStringLiteral("ty")},
-    {Tajik, QStringLiteral("tg")},
-    {Tamil, QStringLiteral("ta")},
-    {Tatar, QStringLiteral("tt")},
-    {Telugu, QStringLiteral("te")},
-    {Thai, QStringLiteral("th")},
-    {Tongan, QStringLiteral("to")},
-    {TraditionalChinese, QStringLiteral("zh-TW")},
-    {Turkish, QStringLiteral("tr")},
-    {Turkmen, QStringLiteral("tk")},
-    {Udmurt, QStringLiteral("udm")},
-    {Uighur, QStringLiteral("ug")},
-    {Ukrainian, QStringLiteral("uk")},
-    {Urdu, QStringLiteral("ur")},
-    {Uzbek, QStringLiteral("uz")},
-    {Vietnamese, QStringLiteral("vi")},
-    {Welsh, QStringLiteral("cy")},
-    {Xhosa, QStringLiteral("xh")},
-    {Yiddish, QStringLiteral("yi")},
-    {Yoruba, QStringLiteral("yo")},
-    {YucatecMaya, QStringLiteral("yua")},
-    {Zulu, QStringLiteral("zu")}};
-
-const QMap<QOnlineTranslator::Language, QString> QOnlineTranslator::s_googleLanguageCodes = {
-    {Hebrew, QStringLiteral("iw")}};
-
-const QMap<QOnlineTranslator::Language, QString> QOnlineTranslator::s_yandexLanguageCodes = {
-    {SimplifiedChinese, QStringLiteral("zn")},
-    {Javanese, QStringLiteral("jv")}};
-
-const QMap<QOnlineTranslator::Language, QString> QOnlineTranslator::s_bingLanguageCodes = {
-    {Auto, QStringLiteral("auto-detect")},
-    {Bosnian, QStringLiteral("bs-Latn")},
-    {SerbianCyrillic, QStringLiteral("sr-Cyrl")},
-    {SimplifiedChinese, QStringLiteral("zh-Hans")},
-    {TraditionalChinese, QStringLiteral("zh-Hant")},
-    {Hmong, QStringLiteral("mww")}};
-
-const QMap<QOnlineTranslator::Language, QString> QOnlineTranslator::s_lingvaLanguageCodes = {
-    {SimplifiedChinese, QStringLiteral("zh")},
-    {TraditionalChinese, QStringLiteral("zh_HANT")}};
+#include <QTimer>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <random>
+#include <utility>
+
+namespace
+{
+// Languages with NoLanguage, which is -1
+constexpr int s_languageCount = QOnlineTranslator::Zulu + 2;
+constexpr int s_engineCount = QOnlineTranslator::Lingva + 1;
+
+// Bit set of languages and a bit set of translation languages for each source language
+using LanguageSet = std::array<quint64, (s_languageCount + 63) / 64>;
+using LanguagePairs = std::array<LanguageSet, s_languageCount>;
+
+constexpr int languageIndex(QOnlineTranslator::Language lang)
+{
+    return lang + 1;
+}
+
+constexpr bool contains(const LanguageSet &languages, QOnlineTranslator::Language lang)
+{
+    const int index = languageIndex(lang);
+    return (languages[index / 64] >> (index % 64)) & 1;
+}
+
+template<typename Predicate>
+constexpr LanguageSet makeLanguageSet(Predicate predicate)
+{
+    LanguageSet languages{};
+    for (int index = 0; index < s_languageCount; ++index) {
+        if (predicate(static_cast<QOnlineTranslator::Language>(index - 1)))
+            languages[index / 64] |= quint64(1) << (index % 64);
+    }
+    return languages;
+}
+
+template<typename Predicate>
+constexpr LanguagePairs makeLanguagePairs(Predicate predicate)
+{
+    LanguagePairs pairs{};
+    for (int index = 0; index < s_languageCount; ++index) {
+        const auto sourceLang = static_cast<QOnlineTranslator::Language>(index - 1);
+        pairs[index] = makeLanguageSet([&](QOnlineTranslator::Language translationLang) {
+            return predicate(sourceLang, translationLang);
+        });
+    }
+    return pairs;
+}
+}
+
+// Texts of a batch that are packed into a single request
+struct QOnlineTranslator::BatchRequest {
+    QStringList sources;
+    QVector<QVector<int>> groups; // Indexes of texts in each request
+    int currentGroup = -1;
+    Engine engine;
+    Language translationLang;
+    Language sourceLang;
+    Language uiLang;
+    bool aborted = false;
+};
+
+// Network request that is executed as a stage of the translation pipeline
+struct QOnlineTranslator::PipelineStage {
+    QNetworkReply *(QOnlineTranslator::*requestMethod)(const QString &);
+    void (QOnlineTranslator::*parseMethod)(QNetworkReply *);
+    QString QOnlineTranslator::*text; // Read when the stage starts, so it can depend on the previous stages
+    int textLimit; // Text is split into parts by this limit, 0 to send it as is
+    int maxRequests; // Parts that are sent simultaneously
+    bool onlyFirstPart;
+    bool cacheSegments;
+    bool parallel = false; // Started together with the previous stage
+    bool optional = false; // Skipped when the deadline is close
+    QString QOnlineTranslator::*output = nullptr; // Cleared if the optional stage is stopped before all its parts are parsed
+    bool rateReserved = false; // The next part can be sent without waiting for the rate limit
+    bool rateWaiting = false; // The next part is sent when the rate limit allows
+    void (QOnlineTranslator::*readMethod)(ReplyStream &) = nullptr; // Parses replies while they are received
+
+    // Parts of the running stage, refer to the text that was read when the stage started
+    QString partsText;
+    QVector<QTextSplitter::Part> parts;
+    QVector<QPointer<QNetworkReply>> replies;
+    QVector<bool> finishedParts;
+    QVector<int> retryCounts;
+    QVector<bool> timedOutParts;
+    QMap<int, TranslationResult> cachedParts; // Parts taken from cache are applied in order of parsing
+    int sentCount = 0;
+    int parsedCount = 0;
+    int activeCount = 0;
+
+    // Copies the part only when it is needed for a request or a cache key
+    QString part(int index) const
+    {
+        const QTextSplitter::Part &part = parts.at(index);
+        return partsText.mid(part.offset, part.length);
+    }
+};
+
+// Reply data that is parsed while it is received, the result is applied when the part is parsed in order
+struct QOnlineTranslator::ReplyStream {
+    QGoogleReplyReader googleReader;
+    QJsonStreamReader reader; // Reads Lingva replies
+    QByteArray pendingData; // Received data that is not passed to the reader yet
+    TranslationResult result;
+    bool started = false; // The first non-space byte was received
+    bool html = false; // HTML page was returned instead of JSON
+
+    void addData(const QByteArray &data)
+    {
+        for (int i = 0; !started && i < data.size(); ++i) {
+            if (!std::isspace(static_cast<uchar>(data.at(i)))) {
+                started = true;
+                html = data.at(i) == '<';
+            }
+        }
+        pendingData += data;
+    }
+
+    // Passed to the reader of the engine by the read method
+    QByteArray takeData()
+    {
+        return std::exchange(pendingData, {});
+    }
+
+    // Services return HTML pages for errors, e.g. for suspicious traffic, other unreadable replies are parsing errors
+    bool isHtml(QNetworkReply *reply) const
+    {
+        return html || reply->header(QNetworkRequest::ContentTypeHeader).toString().startsWith(QLatin1String("text/html"));
+    }
+
+    // Dictionary group of Lingva reply that is being read
+    QString typeOfSpeech;
+    QVector<QOption> options;
+    QVector<QExample> examples;
+    QOption option;
+    QExample example;
+};
+
+// Runtime data of the translation pipeline, replaced on every translation
+struct QOnlineTranslator::Pipeline {
+    Engine engine = Google; // Receives results in its circuit breaker
+    QString host; // Host of self-hosted instances, used for rate limits
+    QVector<PipelineStage> stages;
+    QHash<QNetworkReply *, ReplyStream> streams; // Replies of stages with read method
+    int nextStage = 0;
+    int activeStages = 0;
+};
+
+namespace
+{
+// Language codes indexed by languageIndex(), nullptr for languages without a code
+using LanguageCodes = std::array<const char *, s_languageCount>;
+
+struct LanguageCode {
+    QOnlineTranslator::Language lang;
+    const char *code;
+};
+
+template<std::size_t Size>
+constexpr LanguageCodes makeLanguageCodes(const LanguageCode (&codes)[Size])
+{
+    LanguageCodes table{};
+    for (const LanguageCode &code : codes)
+        table[languageIndex(code.lang)] = code.code;
+    return table;
+}
+
+constexpr LanguageCodes s_genericLanguageCodes = makeLanguageCodes({
+    {QOnlineTranslator::Auto, "auto"},
+    {QOnlineTranslator::Afrikaans, "af"},
+    {QOnlineTranslator::Albanian, "sq"},
+    {QOnlineTranslator::Amharic, "am"},
+    {QOnlineTranslator::Arabic, "ar"},
+    {QOnlineTranslator::Armenian, "hy"},
+    {QOnlineTranslator::Azerbaijani, "az"},
+    {QOnlineTranslator::Bashkir, "ba"},
+    {QOnlineTranslator::Basque, "eu"},
+    {QOnlineTranslator::Belarusian, "be"},
+    {QOnlineTranslator::Bengali, "bn"},
+    {QOnlineTranslator::Bosnian, "bs"},
+    {QOnlineTranslator::Bulgarian, "bg"},
+    {QOnlineTranslator::Cantonese, "yue"},
+    {QOnlineTranslator::Catalan, "ca"},
+    {QOnlineTranslator::Cebuano, "ceb"},
+    {QOnlineTranslator::Chichewa, "ny"},
+    {QOnlineTranslator::Corsican, "co"},
+    {QOnlineTranslator::Croatian, "hr"},
+    {QOnlineTranslator::Czech, "cs"},
+    {QOnlineTranslator::Danish, "da"},
+    {QOnlineTranslator::Dutch, "nl"},
+    {QOnlineTranslator::English, "en"},
+    {QOnlineTranslator::Esperanto, "eo"},
+    {QOnlineTranslator::Estonian, "et"},
+    {QOnlineTranslator::Fijian, "fj"},
+    {QOnlineTranslator::Filipino, "fil"},
+    {QOnlineTranslator::Finnish, "fi"},
+    {QOnlineTranslator::French, "fr"},
+    {QOnlineTranslator::Frisian, "fy"},
+    {QOnlineTranslator::Galician, "gl"},
+    {QOnlineTranslator::Georgian, "ka"},
+    {QOnlineTranslator::German, "de"},
+    {QOnlineTranslator::Greek, "el"},
+    {QOnlineTranslator::Gujarati, "gu"},
+    {QOnlineTranslator::HaitianCreole, "ht"},
+    {QOnlineTranslator::Hausa, "ha"},
+    {QOnlineTranslator::Hawaiian, "haw"},
+    {QOnlineTranslator::Hebrew, "he"},
+    {QOnlineTranslator::HillMari, "mrj"},
+    {QOnlineTranslator::Hindi, "hi"},
+    {QOnlineTranslator::Hmong, "hmn"},
+    {QOnlineTranslator::Hungarian, "hu"},
+    {QOnlineTranslator::Icelandic, "is"},
+    {QOnlineTranslator::Igbo, "ig"},
+    {QOnlineTranslator::Indonesian, "id"},
+    {QOnlineTranslator::Irish, "ga"},
+    {QOnlineTranslator::Italian, "it"},
+    {QOnlineTranslator::Japanese, "ja"},
+    {QOnlineTranslator::Javanese, "jw"},
+    {QOnlineTranslator::Kannada, "kn"},
+    {QOnlineTranslator::Kazakh, "kk"},
+    {QOnlineTranslator::Khmer, "km"},
+    {QOnlineTranslator::Kinyarwanda, "rw"},
+    {QOnlineTranslator::Klingon, "tlh"},
+    {QOnlineTranslator::KlingonPlqaD, "tlh-Qaak"},
+    {QOnlineTranslator::Korean, "ko"},
+    {QOnlineTranslator::Kurdish, "ku"},
+    {QOnlineTranslator::Kyrgyz, "ky"},
+    {QOnlineTranslator::Lao, "lo"},
+    {QOnlineTranslator::Latin, "la"},
+    {QOnlineTranslator::Latvian, "lv"},
+    {QOnlineTranslator::LevantineArabic, "apc"},
+    {QOnlineTranslator::Lithuanian, "lt"},
+    {QOnlineTranslator::Luxembourgish, "lb"},
+    {QOnlineTranslator::Macedonian, "mk"},
+    {QOnlineTranslator::Malagasy, "mg"},
+    {QOnlineTranslator::Malay, "ms"},
+    {QOnlineTranslator::Malayalam, "ml"},
+    {QOnlineTranslator::Maltese, "mt"},
+    {QOnlineTranslator::Maori, "mi"},
+    {QOnlineTranslator::Marathi, "mr"},
+    {QOnlineTranslator::Mari, "mhr"},
+    {QOnlineTranslator::Mongolian, "mn"},
+    {QOnlineTranslator::Myanmar, "my"},
+    {QOnlineTranslator::Nepali, "ne"},
+    {QOnlineTranslator::Norwegian, "no"},
+    {QOnlineTranslator::Oriya, "or"},
+    {QOnlineTranslator::Papiamento, "pap"},
+    {QOnlineTranslator::Pashto, "ps"},
+    {QOnlineTranslator::Persian, "fa"},
+    {QOnlineTranslator::Polish, "pl"},
+    {QOnlineTranslator::Portuguese, "pt"},
+    {QOnlineTranslator::Punjabi, "pa"},
+    {QOnlineTranslator::QueretaroOtomi, "otq"},
+    {QOnlineTranslator::Romanian, "ro"},
+    {QOnlineTranslator::Russian, "ru"},
+    {QOnlineTranslator::Samoan, "sm"},
+    {QOnlineTranslator::ScotsGaelic, "gd"},
+    {QOnlineTranslator::SerbianCyrillic, "sr"},
+    {QOnlineTranslator::SerbianLatin, "sr-Latin"},
+    {QOnlineTranslator::Sesotho, "st"},
+    {QOnlineTranslator::Shona, "sn"},
+    {QOnlineTranslator::SimplifiedChinese, "zh-CN"},
+    {QOnlineTranslator::Sindhi, "sd"},
+    {QOnlineTranslator::Sinhala, "si"},
+    {QOnlineTranslator::Slovak, "sk"},
+    {QOnlineTranslator::Slovenian, "sl"},
+    {QOnlineTranslator::Somali, "so"},
+    {QOnlineTranslator::Spanish, "es"},
+    {QOnlineTranslator::Sundanese, "su"},
+    {QOnlineTranslator::Swahili, "sw"},
+    {QOnlineTranslator::Swedish, "sv"},
+    {QOnlineTranslator::Tagalog, "tl"},
+    {QOnlineTranslator::Tahitian, "ty"},
+    {QOnlineTranslator::Tajik, "tg"},
+    {QOnlineTranslator::Tamil, "ta"},
+    {QOnlineTranslator::Tatar, "tt"},
+    {QOnlineTranslator::Telugu, "te"},
+    {QOnlineTranslator::Thai, "th"},
+    {QOnlineTranslator::Tongan, "to"},
+    {QOnlineTranslator::TraditionalChinese, "zh-TW"},
+    {QOnlineTranslator::Turkish, "tr"},
+    {QOnlineTranslator::Turkmen, "tk"},
+    {QOnlineTranslator::Udmurt, "udm"},
+    {QOnlineTranslator::Uighur, "ug"},
+    {QOnlineTranslator::Ukrainian, "uk"},
+    {QOnlineTranslator::Urdu, "ur"},
+    {QOnlineTranslator::Uzbek, "uz"},
+    {QOnlineTranslator::Vietnamese, "vi"},
+    {QOnlineTranslator::Welsh, "cy"},
+    {QOnlineTranslator::Xhosa, "xh"},
+    {QOnlineTranslator::Yiddish, "yi"},
+    {QOnlineTranslator::Yoruba, "yo"},
+    {QOnlineTranslator::YucatecMaya, "yua"},
+    {QOnlineTranslator::Zulu, "zu"}});
+
+// Engines have some language codes exceptions
+constexpr LanguageCodes s_googleLanguageCodes = makeLanguageCodes({
+    {QOnlineTranslator::Hebrew, "iw"}});
+
+constexpr LanguageCodes s_yandexLanguageCodes = makeLanguageCodes({
+    {QOnlineTranslator::SimplifiedChinese, "zn"},
+    {QOnlineTranslator::Javanese, "jv"}});
+
+constexpr LanguageCodes s_bingLanguageCodes = makeLanguageCodes({
+    {QOnlineTranslator::Auto, "auto-detect"},
+    {QOnlineTranslator::Bosnian, "bs-Latn"},
+    {QOnlineTranslator::SerbianCyrillic, "sr-Cyrl"},
+    {QOnlineTranslator::SimplifiedChinese, "zh-Hans"},
+    {QOnlineTranslator::TraditionalChinese, "zh-Hant"},
+    {QOnlineTranslator::Hmong, "mww"}});
+
+constexpr LanguageCodes s_lingvaLanguageCodes = makeLanguageCodes({
+    {QOnlineTranslator::SimplifiedChinese, "zh"},
+    {QOnlineTranslator::TraditionalChinese, "zh_HANT"}});
+
+// LibreTranslate uses generic codes
+constexpr LanguageCodes s_libreLanguageCodes{};
+
+constexpr std::array<const LanguageCodes *, s_engineCount> s_engineLanguageCodes = {&s_googleLanguageCodes, &s_yandexLanguageCodes, &s_bingLanguageCodes, &s_libreLanguageCodes, &s_lingvaLanguageCodes};
+
+// Engine exceptions have priority over generic codes
+QHash<QString, QOnlineTranslator::Language> languageCodesIndex(const LanguageCodes &codes, const LanguageCodes &exceptions = {})
+{
+    QHash<QString, QOnlineTranslator::Language> index;
+    index.reserve(s_languageCount);
+
+    // Keep the first language for duplicated codes
+    for (const LanguageCodes *table : {&exceptions, &codes}) {
+        for (int i = 0; i < s_languageCount; ++i) {
+            if ((*table)[i] == nullptr)
+                continue;
+
+            const QString code = QLatin1String((*table)[i]);
+            if (!index.contains(code))
+                index.insert(code, static_cast<QOnlineTranslator::Language>(i - 1));
+        }
+    }
+
+    return index;
+}
+}
 
 QOnlineTranslator::QOnlineTranslator(QObject *parent)
     : QObject(parent)
-    , m_stateMachine(new QStateMachine(this))
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_pipelineTimer(new QTimer(this))
+    , m_cachedFinishTimer(new QTimer(this))
+    , m_hedgeTimer(new QTimer(this))
+    , m_deadlineTimer(new QTimer(this))
+{
+    m_pipelineTimer->setSingleShot(true);
+    m_pipelineTimer->setInterval(0);
+    m_cachedFinishTimer->setSingleShot(true);
+    m_cachedFinishTimer->setInterval(0);
+    m_hedgeTimer->setSingleShot(true);
+    m_deadlineTimer->setSingleShot(true);
+
+    connect(m_pipelineTimer, &QTimer::timeout, this, [this] {
+        // Copy the pointer because the pipeline can be stopped during processing
+        const std::shared_ptr<Pipeline> pipeline = m_pipeline;
+        if (pipeline != nullptr)
+            startPipelineStep(pipeline);
+    });
+    connect(m_cachedFinishTimer, &QTimer::timeout, this, &QOnlineTranslator::finishTranslation);
+    connect(m_hedgeTimer, &QTimer::timeout, this, &QOnlineTranslator::startHedge);
+    connect(m_deadlineTimer, &QTimer::timeout, this, &QOnlineTranslator::expireDeadline);
+}
+
+QOnlineTranslator::~QOnlineTranslator()
 {
-    connect(m_stateMachine, &QStateMachine::finished, this, &QOnlineTranslator::finished);
-    connect(m_stateMachine, &QStateMachine::stopped, this, &QOnlineTranslator::finished);
+    leaveFlight();
+    releaseEngine(m_key.engine);
 }
 
 void QOnlineTranslator::translate(const QString &text, Engine engine, Language translationLang, Language sourceLang, Language uiLang)
 {
     abort();
+    m_batch.reset();
+    startDeadline();
+
+    m_engineChain = {engine};
+    for (Engine failoverEngine : qAsConst(m_failoverEngines)) {
+        if (!m_engineChain.contains(failoverEngine))
+            m_engineChain.append(failoverEngine);
+    }
+    m_enginePosition = 0;
+
+    startTranslation(text, engine, translationLang, sourceLang, uiLang);
+}
+
+void QOnlineTranslator::translateBatch(const QStringList &texts, Engine engine, Language translationLang, Language sourceLang, Language uiLang)
+{
+    abort();
+    resetData();
+    startDeadline();
+
+    m_batchTranslations = texts;
+    m_batchErrors.fill(NoError, texts.size());
+    m_batchErrorStrings.clear();
+    m_batchErrorStrings.reserve(texts.size());
+    for (int i = 0; i < texts.size(); ++i)
+        m_batchErrorStrings.append(QString());
+
+    m_batch = std::make_shared<BatchRequest>();
+    m_batch->sources = texts;
+    m_batch->engine = engine;
+    m_batch->translationLang = translationLang;
+    m_batch->sourceLang = sourceLang;
+    m_batch->uiLang = uiLang;
+
+    // Pack as many texts as possible into a single request
+    const int limit = translationLimit(engine);
+    QVector<int> group;
+    int groupLength = 0;
+    for (int i = 0; i < texts.size(); ++i) {
+        const QString &text = texts.at(i);
+
+        // Nothing to translate, keep the text as is
+        if (text.trimmed().isEmpty())
+            continue;
+
+        // Text with a separator can't be splitted back, so it should be sent separately
+        if (text.contains(s_batchSeparator)) {
+            m_batch->groups.append(QVector<int>{i});
+            continue;
+        }
+
+        if (!group.isEmpty() && groupLength + 1 + text.size() > limit) {
+            m_batch->groups.append(group);
+            group.clear();
+            groupLength = 0;
+        }
+
+        if (!group.isEmpty())
+            ++groupLength; // Separator
+        group.append(i);
+        groupLength += text.size();
+    }
+    if (!group.isEmpty())
+        m_batch->groups.append(group);
+
+    const std::shared_ptr<BatchRequest> batch = m_batch;
+    QTimer::singleShot(0, this, [this, batch] {
+        translateBatchGroup(batch);
+    });
+}
+
+void QOnlineTranslator::startDeadline()
+{
+    if (m_deadline > 0)
+        m_deadlineTimer->start(m_deadline);
+    else
+        m_deadlineTimer->stop();
+}
+
+void QOnlineTranslator::expireDeadline()
+{
+    // Translation is already received, so it is returned without the additional data.
+    // The result is not cached because it lacks the requested data.
+    const std::shared_ptr<Pipeline> pipeline = m_pipeline;
+    if (pipeline != nullptr && hasOnlyOptionalStages(pipeline)) {
+        for (const PipelineStage &stage : qAsConst(pipeline->stages)) {
+            if (stage.output != nullptr && stage.parsedCount != stage.parts.size())
+                (this->*stage.output).clear();
+        }
+        stopPipeline();
+        reportEngineResult(pipeline->engine, true);
+        finishTranslation();
+        return;
+    }
+
+    const QString errorString = tr("Translation deadline exceeded");
+    if (m_batch != nullptr) {
+        // Texts of the next groups will not be translated
+        m_batch->aborted = true;
+        for (int i = m_batch->currentGroup + 1; i < m_batch->groups.size(); ++i) {
+            for (int index : m_batch->groups.at(i)) {
+                m_batchTranslations[index].clear();
+                m_batchErrors[index] = TimeoutError;
+                m_batchErrorStrings[index] = errorString;
+            }
+        }
+    }
+
+    // Nothing is running between batch groups and for results without requests
+    if (m_pipeline == nullptr && m_followerId == 0 && !m_hedging)
+        return;
+
+    stopHedge();
+    leaveFlight();
+
+    // Replies are aborted by the reset, the translation is not passed to failover engines
+    m_aborting = true;
+    resetData(TimeoutError, errorString);
+    finishTranslation();
+    m_aborting = false;
+    releaseEngine(m_key.engine);
+}
+
+int QOnlineTranslator::remainingTime() const
+{
+    return m_deadlineTimer->isActive() ? m_deadlineTimer->remainingTime() : -1;
+}
+
+void QOnlineTranslator::startTranslation(const QString &text, Engine engine, Language translationLang, Language sourceLang, Language uiLang)
+{
     resetData();
+    m_libreAutoRejected = false;
 
     m_onlyDetectLanguage = false;
     m_source = text;
@@ -197,60 +554,122 @@ void QOnlineTranslator::translate(const QString &text, Engine engine, Language t
     m_translationLang = translationLang == Auto ? language(QLocale()) : translationLang;
     m_uiLang = uiLang == Auto ? language(QLocale()) : uiLang;
 
+    // Skip engines of the chain that are known to fail
+    if (m_batch == nullptr && m_engineChain.size() > 1) {
+        m_enginePosition = availableEnginePosition(m_enginePosition);
+        if (m_enginePosition == -1) {
+            m_enginePosition = m_engineChain.size();
+            resetData(ServiceError, tr("All engines are unavailable"));
+            finishTranslation();
+            return;
+        }
+        engine = m_engineChain.at(m_enginePosition);
+    }
+
+    // Send the locally identified language, so the engine does not need to detect it
+    if (m_sourceLang == Auto && m_languageIdentifier != nullptr) {
+        const Language localLang = localLanguage(text, engine);
+        if (localLang != NoLanguage)
+            m_sourceLang = localLang;
+    }
+
     // Check if the selected languages are supported by the engine
     if (!isSupportTranslation(engine, m_sourceLang)) {
         resetData(ParametersError, tr("Selected source language %1 is not supported for %2").arg(languageName(m_sourceLang), QMetaEnum::fromType<Engine>().valueToKey(engine)));
-        emit finished();
+        finishTranslation();
         return;
     }
     if (!isSupportTranslation(engine, m_translationLang)) {
         resetData(ParametersError, tr("Selected translation language %1 is not supported for %2").arg(languageName(m_translationLang), QMetaEnum::fromType<Engine>().valueToKey(engine)));
-        emit finished();
+        finishTranslation();
         return;
     }
     if (!isSupportTranslation(engine, m_uiLang)) {
         resetData(ParametersError, tr("Selected ui language %1 is not supported for %2").arg(languageName(m_uiLang), QMetaEnum::fromType<Engine>().valueToKey(engine)));
-        emit finished();
+        finishTranslation();
+        return;
+    }
+
+    m_key = {engine, m_sourceLang, m_translationLang, m_uiLang, 0, m_source};
+    m_key.features = m_sourceTranslitEnabled
+        | m_translationTranslitEnabled << 1
+        | m_sourceTranscriptionEnabled << 2
+        | m_translationOptionsEnabled << 3
+        | m_examplesEnabled << 4
+        | m_offlineTranslitEnabled << 5;
+
+    // Batch requests skip transliteration and dictionaries, so they are not cached
+    if (m_cache != nullptr && m_batch == nullptr) {
+        TranslationResult cachedResult;
+        if (m_cache->find(m_key, cachedResult)) {
+            setResult(cachedResult);
+            m_cachedFinishTimer->start();
+            return;
+        }
+    }
+
+    // Wait for the result of an identical translation instead of sending the same requests
+    if (m_requestCoalescingEnabled && m_batch == nullptr && !m_flightLeader && joinFlight())
+        return;
+
+    // Another object could start probing the engine after it was selected
+    if (m_batch == nullptr && m_engineChain.size() > 1 && !acquireEngine(engine)) {
+        resetData(ServiceError, tr("%1 is unavailable").arg(QMetaEnum::fromType<Engine>().valueToKey(engine)));
+        finishTranslation();
         return;
     }
 
+    startEnginePipeline();
+}
+
+void QOnlineTranslator::startEnginePipeline()
+{
+    const Engine engine = m_key.engine;
+    m_pipeline = std::make_shared<Pipeline>();
+    m_pipeline->engine = engine;
+    m_pipeline->host = instanceHost(engine);
     switch (engine) {
     case Google:
-        buildGoogleStateMachine();
+        buildGooglePipeline();
         break;
     case Yandex:
-        buildYandexStateMachine();
+        buildYandexPipeline();
         break;
     case Bing:
-        buildBingStateMachine();
+        buildBingPipeline();
         break;
     case LibreTranslate:
         if (m_libreUrl.isEmpty()) {
             resetData(ParametersError, tr("%1 URL can't be empty.").arg(QMetaEnum::fromType<Engine>().valueToKey(engine)));
-            emit finished();
+            finishTranslation();
             return;
         }
 
-        buildLibreStateMachine();
+        buildLibrePipeline();
         break;
     case Lingva:
         if (m_lingvaUrl.isEmpty()) {
             resetData(ParametersError, tr("%1 URL can't be empty.").arg(QMetaEnum::fromType<Engine>().valueToKey(engine)));
-            emit finished();
+            finishTranslation();
             return;
         }
 
-        buildLingvaStateMachine();
+        buildLingvaPipeline();
         break;
     }
 
-    m_stateMachine->start();
+    if (m_hedgingEnabled && m_batch == nullptr && m_hedgeEngine != engine)
+        m_hedgeTimer->start(hedgeDelay(engine, m_hedgePercentile));
+
+    startPipeline();
 }
 
 void QOnlineTranslator::detectLanguage(const QString &text, Engine engine)
 {
     abort();
     resetData();
+    m_batch.reset();
+    startDeadline();
 
     m_onlyDetectLanguage = true;
     m_source = text;
@@ -258,15 +677,26 @@ void QOnlineTranslator::detectLanguage(const QString &text, Engine engine)
     m_translationLang = English;
     m_uiLang = language(QLocale());
 
+    // Languages with their own script or known to the local identifier are detected without requests
+    const Language localLang = localLanguage(text, engine);
+    if (localLang != NoLanguage) {
+        m_sourceLang = localLang;
+        m_cachedFinishTimer->start();
+        return;
+    }
+
+    m_pipeline = std::make_shared<Pipeline>();
+    m_pipeline->engine = engine;
+    m_pipeline->host = instanceHost(engine);
     switch (engine) {
     case Google:
-        buildGoogleDetectStateMachine();
+        buildGoogleDetectPipeline();
         break;
     case Yandex:
-        buildYandexDetectStateMachine();
+        buildYandexDetectPipeline();
         break;
     case Bing:
-        buildBingDetectStateMachine();
+        buildBingDetectPipeline();
         break;
     case LibreTranslate:
         if (m_libreUrl.isEmpty()) {
@@ -275,7 +705,7 @@ void QOnlineTranslator::detectLanguage(const QString &text, Engine engine)
             return;
         }
 
-        buildLibreDetectStateMachine();
+        buildLibreDetectPipeline();
         break;
     case Lingva:
         if (m_lingvaUrl.isEmpty()) {
@@ -284,22 +714,64 @@ void QOnlineTranslator::detectLanguage(const QString &text, Engine engine)
             return;
         }
 
-        buildLingvaDetectStateMachine();
+        buildLingvaDetectPipeline();
         break;
     }
 
-    m_stateMachine->start();
+    startPipeline();
 }
 
 void QOnlineTranslator::abort()
 {
-    if (m_currentReply != nullptr)
-        m_currentReply->abort();
+    if (m_batch != nullptr)
+        m_batch->aborted = true;
+
+    // The selected engine already failed and only the hedge engine is running
+    const bool waitingForHedge = m_hedging && m_pipeline == nullptr;
+
+    // Otherwise aborted requests would wait for the hedge engine
+    stopHedge();
+
+    // Requests of the leader are not affected
+    if (m_followerId != 0) {
+        leaveFlight();
+        resetData(NetworkError, tr("Operation canceled"));
+        finishTranslation();
+        return;
+    }
+
+    // Followers continue the translation without this object
+    leaveFlight();
+
+    // Not passed to failover engines as any other aborted translation
+    if (waitingForHedge) {
+        m_aborting = true;
+        resetData(NetworkError, tr("Operation canceled"));
+        finishTranslation();
+        m_aborting = false;
+        return;
+    }
+
+    // Copy the list because aborting triggers parsing, which may reset data
+    const QList<QPointer<QNetworkReply>> replies = m_replies;
+    m_aborting = true;
+    for (const QPointer<QNetworkReply> &reply : replies) {
+        if (reply != nullptr)
+            reply->abort();
+    }
+
+    // Pipeline without running replies waits for a retry or the rate limit
+    if (m_pipeline != nullptr) {
+        resetData(NetworkError, tr("Operation canceled"));
+        finishTranslation();
+    }
+    m_aborting = false;
+    releaseEngine(m_key.engine);
 }
 
 bool QOnlineTranslator::isRunning() const
 {
-    return m_stateMachine->isRunning();
+    return m_pipeline != nullptr || m_cachedFinishTimer->isActive() || m_batch != nullptr || m_followerId != 0 || m_hedging;
 }
 
 QJsonDocument QOnlineTranslator::toJson() const
@@ -388,6 +860,21 @@ QMap<QString, QVector<QExample>> QOnlineTranslator::examples() const
     return m_examples;
 }
 
+QStringList QOnlineTranslator::batchTranslations() const
+{
+    return m_batchTranslations;
+}
+
+QVector<QOnlineTranslator::TranslationError> QOnlineTranslator::batchErrors() const
+{
+    return m_batchErrors;
+}
+
+QStringList QOnlineTranslator::batchErrorStrings() const
+{
+    return m_batchErrorStrings;
+}
+
 QOnlineTranslator::TranslationError QOnlineTranslator::error() const
 {
     return m_error;
@@ -418,6 +905,16 @@ void QOnlineTranslator::setTranslationTranslitEnabled(bool enable)
     m_translationTranslitEnabled = enable;
 }
 
+bool QOnlineTranslator::isOfflineTranslitEnabled() const
+{
+    return m_offlineTranslitEnabled;
+}
+
+void QOnlineTranslator::setOfflineTranslitEnabled(bool enable)
+{
+    m_offlineTranslitEnabled = enable;
+}
+
 bool QOnlineTranslator::isSourceTranscriptionEnabled() const
 {
     return m_sourceTranscriptionEnabled;
@@ -453,6 +950,7 @@ void QOnlineTranslator::setEngineUrl(Engine engine, QString url)
     switch (engine) {
     case LibreTranslate:
         m_libreUrl = qMove(url);
+        m_libreDetectionFirst = false;
         break;
     case Lingva:
         m_lingvaUrl = qMove(url);
@@ -473,6 +971,172 @@ void QOnlineTranslator::setEngineApiKey(Engine engine, QByteArray apiKey)
     }
 }
 
+QNetworkAccessManager *QOnlineTranslator::networkAccessManager() const
+{
+    // Create own manager only if no shared manager was provided
+    if (m_networkManager == nullptr)
+        m_networkManager = new QNetworkAccessManager(const_cast<QOnlineTranslator *>(this));
+
+    return m_networkManager;
+}
+
+void QOnlineTranslator::setNetworkAccessManager(QNetworkAccessManager *manager)
+{
+    if (m_networkManager == manager)
+        return;
+
+    if (m_networkManager != nullptr && m_networkManager->parent() == this)
+        m_networkManager->deleteLater();
+
+    m_networkManager = manager;
+}
+
+QTranslationCache *QOnlineTranslator::cache() const
+{
+    return m_cache;
+}
+
+void QOnlineTranslator::setCache(QTranslationCache *cache)
+{
+    m_cache = cache;
+}
+
+QLanguageIdentifier *QOnlineTranslator::languageIdentifier() const
+{
+    return m_languageIdentifier;
+}
+
+void QOnlineTranslator::setLanguageIdentifier(QLanguageIdentifier *identifier)
+{
+    m_languageIdentifier = identifier;
+}
+
+bool QOnlineTranslator::isRequestCoalescingEnabled() const
+{
+    return m_requestCoalescingEnabled;
+}
+
+void QOnlineTranslator::setRequestCoalescingEnabled(bool enable)
+{
+    m_requestCoalescingEnabled = enable;
+}
+
+int QOnlineTranslator::maxConcurrentRequests(Engine engine) const
+{
+    return m_maxConcurrentRequests.value(engine, 1);
+}
+
+void QOnlineTranslator::setMaxConcurrentRequests(Engine engine, int count)
+{
+    m_maxConcurrentRequests.insert(engine, qMax(count, 1));
+}
+
+bool QOnlineTranslator::isHedgingEnabled() const
+{
+    return m_hedgingEnabled;
+}
+
+void QOnlineTranslator::setHedgingEnabled(bool enable)
+{
+    m_hedgingEnabled = enable;
+}
+
+QOnlineTranslator::Engine QOnlineTranslator::hedgeEngine() const
+{
+    return m_hedgeEngine;
+}
+
+void QOnlineTranslator::setHedgeEngine(Engine engine)
+{
+    m_hedgeEngine = engine;
+}
+
+qreal QOnlineTranslator::hedgePercentile() const
+{
+    return m_hedgePercentile;
+}
+
+void QOnlineTranslator::setHedgePercentile(qreal percentile)
+{
+    m_hedgePercentile = percentile;
+}
+
+QVector<QOnlineTranslator::Engine> QOnlineTranslator::failoverEngines() const
+{
+    return m_failoverEngines;
+}
+
+void QOnlineTranslator::setFailoverEngines(const QVector<Engine> &engines)
+{
+    m_failoverEngines = engines;
+}
+
+int QOnlineTranslator::requestTimeout() const
+{
+    return m_requestTimeout;
+}
+
+void QOnlineTranslator::setRequestTimeout(int msec)
+{
+    m_requestTimeout = msec;
+}
+
+int QOnlineTranslator::deadline() const
+{
+    return m_deadline;
+}
+
+void QOnlineTranslator::setDeadline(int msec)
+{
+    m_deadline = msec;
+}
+
+void QOnlineTranslator::setRateLimit(Engine engine, qreal rate, int burst)
+{
+    QMutexLocker locker(&s_rateLimitsMutex);
+    if (rate <= 0)
+        s_engineRateLimits.remove(engine);
+    else
+        setRateLimit(s_engineRateLimits[engine], rate, burst);
+}
+
+void QOnlineTranslator::setHostRateLimit(const QString &host, qreal rate, int burst)
+{
+    QMutexLocker locker(&s_rateLimitsMutex);
+    if (rate <= 0)
+        s_hostRateLimits.remove(host);
+    else
+        setRateLimit(s_hostRateLimits[host], rate, burst);
+}
+
+QOnlineTranslator::RateLimitStats QOnlineTranslator::rateLimitStats(Engine engine)
+{
+    QMutexLocker locker(&s_rateLimitsMutex);
+    return s_engineRateLimits.value(engine).stats;
+}
+
+QOnlineTranslator::RateLimitStats QOnlineTranslator::hostRateLimitStats(const QString &host)
+{
+    QMutexLocker locker(&s_rateLimitsMutex);
+    return s_hostRateLimits.value(host).stats;
+}
+
+bool QOnlineTranslator::isEngineAvailable(Engine engine)
+{
+    QMutexLocker locker(&s_breakersMutex);
+    const CircuitBreaker breaker = s_breakers.value(engine);
+    switch (breaker.state) {
+    case CircuitBreaker::Closed:
+        return true;
+    case CircuitBreaker::Open:
+    case CircuitBreaker::HalfOpen:
+        // Allow the probe after the open duration, a new probe can be sent if the previous one was lost
+        return QDateTime::currentMSecsSinceEpoch() - breaker.changedAt >= s_breakerOpenDuration;
+    }
+
+    return false;
+}
+
 QString QOnlineTranslator::languageName(Language lang)
 {
     switch (lang) {
@@ -735,7 +1399,7 @@ QString QOnlineTranslator::languageName(Language lang)
 
 QString QOnlineTranslator::languageCode(Language lang)
 {
-    return s_genericLanguageCodes.value(lang);
+    return QLatin1String(s_genericLanguageCodes[languageIndex(lang)]);
 }
 
 QOnlineTranslator::Language QOnlineTranslator::language(const QLocale &locale)
@@ -953,293 +1617,68 @@ QOnlineTranslator::Language QOnlineTranslator::language(const QLocale &locale)
 // Returns general language code
 QOnlineTranslator::Language QOnlineTranslator::language(const QString &langCode)
 {
-    return s_genericLanguageCodes.key(langCode, NoLanguage);
+    // Built on first use
+    static const QHash<QString, Language> genericLanguages = languageCodesIndex(s_genericLanguageCodes);
+    return genericLanguages.value(langCode, NoLanguage);
 }
 
 bool QOnlineTranslator::isSupportTranslation(Engine engine, Language lang)
 {
-    bool isSupported = false;
-
-    switch (engine) {
-    case Google:
-    case Lingva: // Lingva is a frontend to Google Translate
-        switch (lang) {
-        case NoLanguage:
-        case Bashkir:
-        case Cantonese:
-        case Fijian:
-        case Filipino:
-        case Georgian:
-        case HillMari:
-        case Klingon:
-        case KlingonPlqaD:
-        case LevantineArabic:
-        case Mari:
-        case Papiamento:
-        case QueretaroOtomi:
-        case SerbianLatin:
-        case Tahitian:
-        case Tongan:
-        case Udmurt:
-        case YucatecMaya:
-            isSupported = false;
-            break;
-        default:
-            isSupported = true;
-            break;
-        }
-        break;
-    case Yandex:
-        switch (lang) {
-        case NoLanguage:
-        case Cantonese:
-        case Chichewa:
-        case Corsican:
-        case Fijian:
-        case Filipino:
-        case Frisian:
-        case Hausa:
-        case Hawaiian:
-        case Igbo:
-        case Kinyarwanda:
-        case Klingon:
-        case KlingonPlqaD:
-        case Kurdish:
-        case LevantineArabic:
-        case Oriya:
-        case Pashto:
-        case QueretaroOtomi:
-        case Samoan:
-        case SerbianLatin:
-        case Sesotho:
-        case Shona:
-        case Sindhi:
-        case Somali:
-        case Tahitian:
-        case Tongan:
-        case Turkmen:
-        case Uighur:
-        case Yoruba:
-        case YucatecMaya:
-        case Zulu:
-            isSupported = false;
-            break;
-        default:
-            isSupported = true;
-            break;
-        }
-        break;
-    case Bing:
-        switch (lang) {
-        case NoLanguage:
-        case Albanian:
-        case Amharic:
-        case Armenian:
-        case Azerbaijani:
-        case Basque:
-        case Bashkir:
-        case Belarusian:
-        case Cebuano:
-        case Corsican:
-        case Esperanto:
-        case Frisian:
-        case Galician:
-        case Georgian:
-        case Gujarati:
-        case Hausa:
-        case Hawaiian:
-        case HillMari:
-        case Igbo:
-        case Irish:
-        case Javanese:
-        case Kannada:
-        case Kazakh:
-        case Khmer:
-        case Kinyarwanda:
-        case Kurdish:
-        case Kyrgyz:
-        case Lao:
-        case Latin:
-        case Luxembourgish:
-        case Macedonian:
-        case Malayalam:
-        case Maori:
-        case Marathi:
-        case Mari:
-        case Mongolian:
-        case Myanmar:
-        case Nepali:
-        case Oriya:
-        case Chichewa:
-        case Papiamento:
-        case Pashto:
-        case Punjabi:
-        case ScotsGaelic:
-        case Sesotho:
-        case Shona:
-        case Sindhi:
-        case Sinhala:
-        case Somali:
-        case Sundanese:
-        case Tagalog:
-        case Tajik:
-        case Tatar:
-        case Turkmen:
-        case Uighur:
-        case Udmurt:
-        case Uzbek:
-        case Xhosa:
-        case Yiddish:
-        case Yoruba:
-        case Zulu:
-            isSupported = false;
-            break;
-        default:
-            isSupported = true;
-            break;
-        }
-        break;
-    case LibreTranslate:
-        switch (lang) {
-        case NoLanguage:
-        case Afrikaans:
-        case Amharic:
-        case Armenian:
-        case Bashkir:
-        case Basque:
-        case Belarusian:
-        case Bosnian:
-        case Cantonese:
-        case Cebuano:
-        case Chichewa:
-        case Corsican:
-        case Croatian:
-        case Fijian:
-        case Filipino:
-        case Frisian:
-        case Galician:
-        case Georgian:
-        case Gujarati:
-        case HaitianCreole:
-        case Hausa:
-        case Hawaiian:
-        case HillMari:
-        case Hmong:
-        case Icelandic:
-        case Igbo:
-        case Javanese:
-        case Kannada:
-        case Kazakh:
-        case Khmer:
-        case Kinyarwanda:
-        case Klingon:
-        case KlingonPlqaD:
-        case Kurdish:
-        case Kyrgyz:
-        case Lao:
-        case Latin:
-        case LevantineArabic:
-        case Luxembourgish:
-        case Macedonian:
-        case Malagasy:
-        case Malayalam:
-        case Maltese:
-        case Maori:
-        case Marathi:
-        case Mari:
-        case Mongolian:
-        case Myanmar:
-        case Nepali:
-        case Oriya:
-        case Papiamento:
-        case Pashto:
-        case Punjabi:
-        case QueretaroOtomi:
-        case Samoan:
-        case ScotsGaelic:
-        case SerbianCyrillic:
-        case SerbianLatin:
-        case Sesotho:
-        case Shona:
-        case SimplifiedChinese:
-        case Sindhi:
-        case Sinhala:
-        case Somali:
-        case Sundanese:
-        case Swahili:
-        case Tahitian:
-        case Tajik:
-        case Tamil:
-        case Tatar:
-        case Telugu:
-        case Tongan:
-        case Turkmen:
-        case Udmurt:
-        case Uighur:
-        case Urdu:
-        case Uzbek:
-        case Welsh:
-        case Xhosa:
-        case Yiddish:
-        case Yoruba:
-        case YucatecMaya:
-        case Zulu:
-            isSupported = false;
-            break;
-        default:
-            isSupported = true;
-            break;
-        }
-        break;
-    }
-
-    return isSupported;
-}
+    // Generated at compile time from hasTranslation()
+    static constexpr std::array<LanguageSet, s_engineCount> languages = {
+        makeLanguageSet([](Language checkedLang) { return hasTranslation(Google, checkedLang); }),
+        makeLanguageSet([](Language checkedLang) { return hasTranslation(Yandex, checkedLang); }),
+        makeLanguageSet([](Language checkedLang) { return hasTranslation(Bing, checkedLang); }),
+        makeLanguageSet([](Language checkedLang) { return hasTranslation(LibreTranslate, checkedLang); }),
+        makeLanguageSet([](Language checkedLang) { return hasTranslation(Lingva, checkedLang); }),
+    };
 
-void QOnlineTranslator::skipGarbageText()
-{
-    m_translation.append(sender()->property(s_textProperty).toString());
+    return contains(languages[engine], lang);
 }
 
-void QOnlineTranslator::requestGoogleTranslate()
+QNetworkReply *QOnlineTranslator::requestGoogleTranslate(const QString &text)
 {
-    const QString sourceText = sender()->property(s_textProperty).toString();
-
     // Generate API url
     QUrl url(QStringLiteral("https://translate.googleapis.com/translate_a/single"));
     url.setQuery(QStringLiteral("client=gtx&ie=UTF-8&oe=UTF-8&dt=bd&dt=ex&dt=ld&dt=md&dt=rw&dt=rm&dt=ss&dt=t&dt=at&dt=qc&sl=%1&tl=%2&hl=%3&q=%4")
-                     .arg(languageApiCode(Google, m_sourceLang), languageApiCode(Google, m_translationLang), languageApiCode(Google, m_uiLang), QUrl::toPercentEncoding(sourceText)));
+                     .arg(languageApiCode(Google, m_sourceLang), languageApiCode(Google, m_translationLang), languageApiCode(Google, m_uiLang), QUrl::toPercentEncoding(text)));
 
-    m_currentReply = m_networkManager->get(QNetworkRequest(url));
+    return networkAccessManager()->get(QNetworkRequest(url));
 }
 
-void QOnlineTranslator::parseGoogleTranslate()
+void QOnlineTranslator::parseGoogleTranslate(QNetworkReply *reply)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
     // Check for error
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        if (m_currentReply->error() == QNetworkReply::ServiceUnavailableError)
+    if (reply->error() != QNetworkReply::NoError) {
+        if (reply->error() == QNetworkReply::ServiceUnavailableError)
             resetData(ServiceError, tr("Error: Engine systems have detected suspicious traffic from your computer network. Please try your request again later."));
         else
-            resetData(NetworkError, m_currentReply->errorString());
+            resetData(NetworkError, reply->errorString());
         return;
     }
 
-    // Check availability of service
-    const QByteArray data = m_currentReply->readAll();
-    if (data.startsWith('<')) {
+    // Read the rest of the data, the beginning was already read while it was received
+    ReplyStream stream = takeReplyStream(reply);
+    readGoogleTranslate(stream);
+    const QGoogleReplyReader &reader = stream.googleReader;
+
+    // Check availability of service, HTML page is returned instead of JSON for suspicious traffic
+    if (reader.hasError() && stream.isHtml(reply)) {
         resetData(ServiceError, tr("Error: Engine systems have detected suspicious traffic from your computer network. Please try your request again later."));
         return;
     }
 
-    // Read Json
-    const QJsonDocument jsonResponse = QJsonDocument::fromJson(data);
-    const QJsonArray jsonData = jsonResponse.array();
+    // Reply is malformed or truncated
+    if (reader.hasError() || !reader.atEnd()) {
+        resetData(ParsingError, tr("Error: Unable to parse the reply"));
+        return;
+    }
 
     if (m_sourceLang == Auto) {
         // Parse language
-        m_sourceLang = language(Google, jsonData.at(2).toString());
+        m_sourceLang = language(Google, reader.sourceLanguageCode());
         if (m_sourceLang == NoLanguage) {
             resetData(ParsingError, tr("Error: Unable to parse autodetected language"));
             return;
@@ -1251,68 +1690,38 @@ void QOnlineTranslator::parseGoogleTranslate()
     addSpaceBetweenParts(m_translation);
     addSpaceBetweenParts(m_translationTranslit);
     addSpaceBetweenParts(m_sourceTranslit);
-    for (const QJsonValueRef translationData : jsonData.at(0).toArray()) {
-        const QJsonArray translationArray = translationData.toArray();
-        m_translation.append(translationArray.at(0).toString());
-        if (m_translationTranslitEnabled)
-            m_translationTranslit.append(translationArray.at(2).toString());
-        if (m_sourceTranslitEnabled)
-            m_sourceTranslit.append(translationArray.at(3).toString());
-    }
-
-    if (m_source.size() >= s_googleTranslateLimit)
-        return;
-
-    // Translation options
-    if (m_translationOptionsEnabled) {
-        for (const QJsonValueRef typeOfSpeechData : jsonData.at(1).toArray()) {
-            const QJsonArray typeOfSpeechDataArray = typeOfSpeechData.toArray();
-            const QString typeOfSpeech = typeOfSpeechDataArray.at(0).toString();
-            for (const QJsonValueRef wordData : typeOfSpeechDataArray.at(2).toArray()) {
-                const QJsonArray wordDataArray = wordData.toArray();
-                const QString word = wordDataArray.at(0).toString();
-                const QString gender = wordDataArray.at(4).toString();
-                const QJsonArray translationsArray = wordDataArray.at(1).toArray();
-                QStringList translations;
-                translations.reserve(translationsArray.size());
-                for (const QJsonValue &wordTranslation : translationsArray)
-                    translations.append(wordTranslation.toString());
-                m_translationOptions[typeOfSpeech].append({word, gender, translations});
-            }
-        }
-    }
-
-    // Examples
-    if (m_examplesEnabled) {
-        for (const QJsonValueRef examplesData : jsonData.at(12).toArray()) {
-            const QJsonArray examplesDataArray = examplesData.toArray();
-            const QString typeOfSpeech = examplesDataArray.at(0).toString();
+    m_translation.append(reader.translation());
+    m_translationTranslit.append(reader.translationTranslit());
+    m_sourceTranslit.append(reader.sourceTranslit());
+    stream.result.translationOptions = reader.translationOptions();
+    stream.result.examples = reader.examples();
+    appendDictionary(stream.result);
+}
 
-            for (const QJsonValueRef exampleData : examplesDataArray.at(1).toArray()) {
-                const QJsonArray exampleArray = exampleData.toArray();
-                const QString example = exampleArray.at(2).toString();
-                const QString definition = exampleArray.at(0).toString();
+void QOnlineTranslator::readGoogleTranslate(ReplyStream &stream)
+{
+    QGoogleReplyReader &reader = stream.googleReader;
+    reader.setTranslationTranslitEnabled(m_translationTranslitEnabled);
+    reader.setSourceTranslitEnabled(m_sourceTranslitEnabled);
 
-                m_examples[typeOfSpeech].append({example, definition});
-            }
-        }
-    }
+    // Dictionary is not requested for split texts
+    reader.setTranslationOptionsEnabled(m_translationOptionsEnabled && m_source.size() < s_googleTranslateLimit);
+    reader.setExamplesEnabled(m_examplesEnabled && m_source.size() < s_googleTranslateLimit);
+    reader.addData(stream.takeData());
 }
 
-void QOnlineTranslator::requestYandexTranslate()
+QNetworkReply *QOnlineTranslator::requestYandexTranslate(const QString &text)
 {
-    const QString sourceText = sender()->property(s_textProperty).toString();
-
     QString lang;
     if (m_sourceLang == Auto)
         lang = languageApiCode(Yandex, m_translationLang);
     else
-        lang = languageApiCode(Yandex, m_sourceLang) + '-' + languageApiCode(Yandex, m_translationLang);
+        lang = QString(languageApiCode(Yandex, m_sourceLang)) + '-' + languageApiCode(Yandex, m_translationLang);
 
     // Generate API url
     QUrl url(QStringLiteral("https://translate.yandex.net/api/v1/tr.json/translate"));
     url.setQuery(QStringLiteral("ucid=%1&srv=android&text=%2&lang=%3")
-                     .arg(s_yandexUcid, QUrl::toPercentEncoding(sourceText), lang));
+                     .arg(s_yandexUcid, QUrl::toPercentEncoding(text), lang));
 
     // Setup request
     QNetworkRequest request;
@@ -1320,30 +1729,30 @@ void QOnlineTranslator::requestYandexTranslate()
     request.setUrl(url);
 
     // Make reply
-    m_currentReply = m_networkManager->post(request, QByteArray());
+    return networkAccessManager()->post(request, QByteArray());
 }
 
-void QOnlineTranslator::parseYandexTranslate()
+void QOnlineTranslator::parseYandexTranslate(QNetworkReply *reply)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
     // Check for errors
-    if (m_currentReply->error() != QNetworkReply::NoError) {
+    if (reply->error() != QNetworkReply::NoError) {
         // Network errors
-        if (m_currentReply->error() < QNetworkReply::ContentAccessDenied) {
-            resetData(NetworkError, m_currentReply->errorString());
+        if (reply->error() < QNetworkReply::ContentAccessDenied) {
+            resetData(NetworkError, reply->errorString());
             return;
         }
 
         // Parse data to get request error type
         s_yandexUcid.clear();
-        const QJsonDocument jsonResponse = QJsonDocument::fromJson(m_currentReply->readAll());
+        const QJsonDocument jsonResponse = QJsonDocument::fromJson(reply->readAll());
         resetData(ServiceError, jsonResponse.object().value(QStringLiteral("message")).toString());
         return;
     }
 
     // Read Json
-    const QJsonDocument jsonResponse = QJsonDocument::fromJson(m_currentReply->readAll());
+    const QJsonDocument jsonResponse = QJsonDocument::fromJson(reply->readAll());
     const QJsonObject jsonData = jsonResponse.object();
 
     // Parse language
@@ -1363,56 +1772,52 @@ void QOnlineTranslator::parseYandexTranslate()
     m_translation += jsonData.value(QStringLiteral("text")).toArray().at(0).toString();
 }
 
-void QOnlineTranslator::requestYandexSourceTranslit()
+QNetworkReply *QOnlineTranslator::requestYandexSourceTranslit(const QString &text)
 {
-    requestYandexTranslit(m_sourceLang);
+    return requestYandexTranslit(m_sourceLang, text, m_sourceTranslit);
 }
 
-void QOnlineTranslator::parseYandexSourceTranslit()
+void QOnlineTranslator::parseYandexSourceTranslit(QNetworkReply *reply)
 {
-    parseYandexTranslit(m_sourceTranslit);
+    parseYandexTranslit(reply, m_sourceTranslit);
 }
 
-void QOnlineTranslator::requestYandexTranslationTranslit()
+QNetworkReply *QOnlineTranslator::requestYandexTranslationTranslit(const QString &text)
 {
-    requestYandexTranslit(m_translationLang);
+    return requestYandexTranslit(m_translationLang, text, m_translationTranslit);
 }
 
-void QOnlineTranslator::parseYandexTranslationTranslit()
+void QOnlineTranslator::parseYandexTranslationTranslit(QNetworkReply *reply)
 {
-    parseYandexTranslit(m_translationTranslit);
+    parseYandexTranslit(reply, m_translationTranslit);
 }
 
-void QOnlineTranslator::requestYandexDictionary()
+QNetworkReply *QOnlineTranslator::requestYandexDictionary(const QString &text)
 {
     // Check if language is supported (need to check here because language may be autodetected)
-    if (!isSupportDictionary(Yandex, m_sourceLang, m_translationLang) && !m_source.contains(' ')) {
-        auto *state = qobject_cast<QState *>(sender());
-        state->addTransition(new QFinalState(state->parentState()));
-        return;
-    }
+    if (!isSupportDictionary(Yandex, m_sourceLang, m_translationLang) && !m_source.contains(' '))
+        return nullptr;
 
     // Generate API url
-    const QString text = sender()->property(s_textProperty).toString();
     QUrl url(QStringLiteral("https://dictionary.yandex.net/dicservice.json/lookupMultiple"));
     url.setQuery(QStringLiteral("text=%1&ui=%2&dict=%3-%4")
                      .arg(QUrl::toPercentEncoding(text), languageApiCode(Yandex, m_uiLang), languageApiCode(Yandex, m_sourceLang), languageApiCode(Yandex, m_translationLang)));
 
-    m_currentReply = m_networkManager->get(QNetworkRequest(url));
+    return networkAccessManager()->get(QNetworkRequest(url));
 }
 
-void QOnlineTranslator::parseYandexDictionary()
+void QOnlineTranslator::parseYandexDictionary(QNetworkReply *reply)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        resetData(NetworkError, m_currentReply->errorString());
+    if (reply->error() != QNetworkReply::NoError) {
+        resetData(NetworkError, reply->errorString());
         return;
     }
 
     // Parse reply
-    const QJsonDocument jsonResponse = QJsonDocument::fromJson(m_currentReply->readAll());
-    const QJsonValue jsonData = jsonResponse.object().value(languageApiCode(Yandex, m_sourceLang) + '-' + languageApiCode(Yandex, m_translationLang)).toObject().value(QStringLiteral("regular"));
+    const QJsonDocument jsonResponse = QJsonDocument::fromJson(reply->readAll());
+    const QJsonValue jsonData = jsonResponse.object().value(QString(languageApiCode(Yandex, m_sourceLang)) + '-' + languageApiCode(Yandex, m_translationLang)).toObject().value(QStringLiteral("regular"));
 
     if (m_sourceTranscriptionEnabled)
         m_sourceTranscription = jsonData.toArray().at(0).toObject().value(QStringLiteral("ts")).toString();
@@ -1447,22 +1852,22 @@ void QOnlineTranslator::parseYandexDictionary()
     }
 }
 
-void QOnlineTranslator::requestBingCredentials()
+QNetworkReply *QOnlineTranslator::requestBingCredentials(const QString &)
 {
     const QUrl url(QStringLiteral("https://www.bing.com/translator"));
-    m_currentReply = m_networkManager->get(QNetworkRequest(url));
+    return networkAccessManager()->get(QNetworkRequest(url));
 }
 
-void QOnlineTranslator::parseBingCredentials()
+void QOnlineTranslator::parseBingCredentials(QNetworkReply *reply)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        resetData(NetworkError, m_currentReply->errorString());
+    if (reply->error() != QNetworkReply::NoError) {
+        resetData(NetworkError, reply->errorString());
         return;
     }
 
-    const QByteArray webSiteData = m_currentReply->readAll();
+    const QByteArray webSiteData = reply->readAll();
     // Previously credentials variable name was "params_RichTranslateHelper", now it called
     // "params_AbusePreventionHelper". OH, IRONY!
     const QByteArray abuseBeginString = "var params_AbusePreventionHelper = [";
@@ -1510,14 +1915,12 @@ void QOnlineTranslator::parseBingCredentials()
     s_bingIid = webSiteData.mid(iidBeginPos + iidString.size(), iidEndPos - (iidBeginPos + iidString.size()));
 }
 
-void QOnlineTranslator::requestBingTranslate()
+QNetworkReply *QOnlineTranslator::requestBingTranslate(const QString &text)
 {
-    const QString sourceText = sender()->property(s_textProperty).toString();
-
     // Generate POST data
-    const QByteArray postData = "&text=" + QUrl::toPercentEncoding(sourceText)
-        + "&fromLang=" + languageApiCode(Bing, m_sourceLang).toUtf8()
-        + "&to=" + languageApiCode(Bing, m_translationLang).toUtf8()
+    const QByteArray postData = "&text=" + QUrl::toPercentEncoding(text)
+        + "&fromLang=" + languageApiCode(Bing, m_sourceLang).latin1()
+        + "&to=" + languageApiCode(Bing, m_translationLang).latin1()
         + "&token=" + s_bingToken
         + "&key=" + s_bingKey;
 
@@ -1531,21 +1934,21 @@ void QOnlineTranslator::requestBingTranslate()
     request.setUrl(url);
 
     // Make reply
-    m_currentReply = m_networkManager->post(request, postData);
+    return networkAccessManager()->post(request, postData);
 }
 
-void QOnlineTranslator::parseBingTranslate()
+void QOnlineTranslator::parseBingTranslate(QNetworkReply *reply)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
     // Check for errors
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        resetData(NetworkError, m_currentReply->errorString());
+    if (reply->error() != QNetworkReply::NoError) {
+        resetData(NetworkError, reply->errorString());
         return;
     }
 
     // Parse translation data
-    const QJsonDocument jsonResponse = QJsonDocument::fromJson(m_currentReply->readAll());
+    const QJsonDocument jsonResponse = QJsonDocument::fromJson(reply->readAll());
     const QJsonObject responseObject = jsonResponse.array().first().toObject();
 
     if (!jsonResponse.object().value(QStringLiteral("statusCode")).isNull()) {
@@ -1574,38 +1977,35 @@ void QOnlineTranslator::parseBingTranslate()
     m_translationTranslit += translationsObject.value(QStringLiteral("transliteration")).toObject().value(QStringLiteral("text")).toString();
 }
 
-void QOnlineTranslator::requestBingDictionary()
+QNetworkReply *QOnlineTranslator::requestBingDictionary(const QString &text)
 {
     // Check if language is supported (need to check here because language may be autodetected)
-    if (!isSupportDictionary(Bing, m_sourceLang, m_translationLang) && !m_source.contains(' ')) {
-        auto *state = qobject_cast<QState *>(sender());
-        state->addTransition(new QFinalState(state->parentState()));
-        return;
-    }
+    if (!isSupportDictionary(Bing, m_sourceLang, m_translationLang) && !m_source.contains(' '))
+        return nullptr;
 
     // Generate POST data
-    const QByteArray postData = "&text=" + QUrl::toPercentEncoding(sender()->property(s_textProperty).toString())
-        + "&from=" + languageApiCode(Bing, m_sourceLang).toUtf8()
-        + "&to=" + languageApiCode(Bing, m_translationLang).toUtf8();
+    const QByteArray postData = "&text=" + QUrl::toPercentEncoding(text)
+        + "&from=" + languageApiCode(Bing, m_sourceLang).latin1()
+        + "&to=" + languageApiCode(Bing, m_translationLang).latin1();
 
     QNetworkRequest request;
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
     request.setUrl(QStringLiteral("https://www.bing.com/tlookupv3"));
 
-    m_currentReply = m_networkManager->post(request, postData);
+    return networkAccessManager()->post(request, postData);
 }
 
-void QOnlineTranslator::parseBingDictionary()
+void QOnlineTranslator::parseBingDictionary(QNetworkReply *reply)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
     // Check for errors
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        resetData(NetworkError, m_currentReply->errorString());
+    if (reply->error() != QNetworkReply::NoError) {
+        resetData(NetworkError, reply->errorString());
         return;
     }
 
-    const QJsonDocument jsonResponse = QJsonDocument::fromJson(m_currentReply->readAll());
+    const QJsonDocument jsonResponse = QJsonDocument::fromJson(reply->readAll());
     const QJsonObject responseObject = jsonResponse.array().first().toObject();
 
     for (const QJsonValueRef dictionaryData : responseObject.value(QStringLiteral("translations")).toArray()) {
@@ -1622,12 +2022,13 @@ void QOnlineTranslator::parseBingDictionary()
     }
 }
 
-void QOnlineTranslator::requestLibreLangDetection()
+QNetworkReply *QOnlineTranslator::requestLibreLangDetection(const QString &text)
 {
-    const QString sourceText = sender()->property(s_textProperty).toString();
+    if (m_sourceLang != Auto)
+        return nullptr;
 
     // Generate POST data
-    const QByteArray postData = "&q=" + QUrl::toPercentEncoding(sourceText)
+    const QByteArray postData = "&q=" + QUrl::toPercentEncoding(text)
         + "&api_key=" + m_libreApiKey;
 
     // Setup request
@@ -1636,20 +2037,20 @@ void QOnlineTranslator::requestLibreLangDetection()
     request.setUrl(m_libreUrl + "/detect");
 
     // Make reply
-    m_currentReply = m_networkManager->post(request, postData);
+    return networkAccessManager()->post(request, postData);
 }
 
-void QOnlineTranslator::parseLibreLangDetection()
+void QOnlineTranslator::parseLibreLangDetection(QNetworkReply *reply)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
     // Check for errors
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        resetData(NetworkError, m_currentReply->errorString());
+    if (reply->error() != QNetworkReply::NoError) {
+        resetData(NetworkError, reply->errorString());
         return;
     }
 
-    const QJsonDocument jsonResponse = QJsonDocument::fromJson(m_currentReply->readAll());
+    const QJsonDocument jsonResponse = QJsonDocument::fromJson(reply->readAll());
     const QJsonObject responseObject = jsonResponse.array().first().toObject();
 
     if (m_sourceLang == Auto) {
@@ -1661,14 +2062,12 @@ void QOnlineTranslator::parseLibreLangDetection()
     }
 }
 
-void QOnlineTranslator::requestLibreTranslate()
+QNetworkReply *QOnlineTranslator::requestLibreTranslate(const QString &text)
 {
-    const QString sourceText = sender()->property(s_textProperty).toString();
-
     // Generate POST data
-    const QByteArray postData = "&q=" + QUrl::toPercentEncoding(sourceText)
-        + "&source=" + languageApiCode(LibreTranslate, m_sourceLang).toUtf8()
-        + "&target=" + languageApiCode(LibreTranslate, m_translationLang).toUtf8()
+    const QByteArray postData = "&q=" + QUrl::toPercentEncoding(text)
+        + "&source=" + languageApiCode(LibreTranslate, m_sourceLang).latin1()
+        + "&target=" + languageApiCode(LibreTranslate, m_translationLang).latin1()
         + "&api_key=" + m_libreApiKey;
 
     // Setup request
@@ -1677,369 +2076,1161 @@ void QOnlineTranslator::requestLibreTranslate()
     request.setUrl(m_libreUrl + "/translate");
 
     // Make reply
-    m_currentReply = m_networkManager->post(request, postData);
+    return networkAccessManager()->post(request, postData);
 }
 
-void QOnlineTranslator::parseLibreTranslate()
+void QOnlineTranslator::parseLibreTranslate(QNetworkReply *reply)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
     // Check for errors
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        resetData(NetworkError, m_currentReply->errorString());
+    if (reply->error() != QNetworkReply::NoError) {
+        // Older servers reject "auto" source as a bad request
+        if (m_sourceLang == Auto && !m_libreDetectionFirst && reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 400) {
+            resetData(ParametersError, reply->errorString());
+            m_libreAutoRejected = true;
+            return;
+        }
+
+        resetData(NetworkError, reply->errorString());
         return;
     }
 
-    const QJsonDocument jsonResponse = QJsonDocument::fromJson(m_currentReply->readAll());
+    const QJsonDocument jsonResponse = QJsonDocument::fromJson(reply->readAll());
     const QJsonObject responseObject = jsonResponse.object();
 
+    if (m_sourceLang == Auto) {
+        const QString langCode = responseObject.value(QStringLiteral("detectedLanguage")).toObject().value(QStringLiteral("language")).toString();
+        if (!langCode.isEmpty()) {
+            m_sourceLang = language(LibreTranslate, langCode);
+            if (m_sourceLang == NoLanguage) {
+                resetData(ParsingError, tr("Error: Unable to parse autodetected language"));
+                return;
+            }
+        }
+    }
+
     m_translation += responseObject.value(QStringLiteral("translatedText")).toString();
 }
 
-void QOnlineTranslator::requestLingvaTranslate()
+QNetworkReply *QOnlineTranslator::requestLingvaTranslate(const QString &text)
 {
-    const QString sourceText = sender()->property(s_textProperty).toString();
-
     // Generate API url
     QUrl url(m_lingvaUrl + "/api/v1/"
              + languageApiCode(Lingva, m_sourceLang) + "/"
              + languageApiCode(Lingva, m_translationLang) + "/"
-             + QUrl::toPercentEncoding(sourceText));
+             + QUrl::toPercentEncoding(text));
 
-    m_currentReply = m_networkManager->get(QNetworkRequest(url));
+    return networkAccessManager()->get(QNetworkRequest(url));
 }
 
-void QOnlineTranslator::parseLingvaTranslate()
+void QOnlineTranslator::parseLingvaTranslate(QNetworkReply *reply)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
     // Check for errors
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        resetData(NetworkError, m_currentReply->errorString());
+    if (reply->error() != QNetworkReply::NoError) {
+        resetData(NetworkError, reply->errorString());
         return;
     }
 
-    // Parse translation data
-    const QJsonDocument jsonResponse = QJsonDocument::fromJson(m_currentReply->readAll());
-    const QJsonObject responseObject = jsonResponse.object();
-    const QJsonObject jsonData = responseObject.value(QStringLiteral("info")).toObject();
-
-    // Parse translation itself
-    m_translation = responseObject.value(QStringLiteral("translation")).toString();
-
-    // Parse transliteration, if enabled
-    if (m_translationTranslitEnabled)
-        m_translationTranslit = jsonData.value(QStringLiteral("pronunciation"))
-                                    .toObject()
-                                    .value(QStringLiteral("translation"))
-                                    .toString();
-
-    // Translation options
-    if (m_translationOptionsEnabled) {
-        for (const QJsonValueRef typeOfSpeechData : jsonData.value(QStringLiteral("extraTranslations")).toArray()) {
-            const QJsonObject speechDataObject = typeOfSpeechData.toObject();
-            const QJsonArray typeOfSpeechDataArray = speechDataObject.value(QStringLiteral("list")).toArray();
-            const QString typeOfSpeech = speechDataObject.value(QStringLiteral("type")).toString();
-            for (const QJsonValue &wordData : typeOfSpeechDataArray) {
-                const QJsonObject wordDataObject = wordData.toObject();
-                const QString word = wordDataObject.value(QStringLiteral("word")).toString();
-                const QJsonArray translationsArray = wordDataObject.value(QStringLiteral("meanings")).toArray();
-                QStringList translations;
-                translations.reserve(translationsArray.size());
-                for (const QJsonValue &wordTranslation : translationsArray)
-                    translations.append(wordTranslation.toString());
-                m_translationOptions[typeOfSpeech].append({word, QString(), translations});
+    // Read the rest of the data, the beginning was already read while it was received
+    ReplyStream stream = takeReplyStream(reply);
+    readLingvaTranslate(stream);
+
+    // Check availability of service, HTML page is returned instead of JSON if the instance is unavailable
+    if (stream.reader.hasError() && stream.isHtml(reply)) {
+        resetData(ServiceError, tr("Error: Service is unavailable. Please try your request again later."));
+        return;
+    }
+
+    // Reply is malformed or truncated
+    if (stream.reader.hasError() || !stream.reader.atEnd()) {
+        resetData(ParsingError, tr("Error: Unable to parse the reply"));
+        return;
+    }
+
+    m_translation += stream.result.translation;
+    m_translationTranslit += stream.result.translationTranslit;
+    appendDictionary(stream.result);
+}
+
+void QOnlineTranslator::readLingvaTranslate(ReplyStream &stream)
+{
+    // Response is an object with translation and additional info
+    QJsonStreamReader &reader = stream.reader;
+    reader.addData(stream.takeData());
+    while (reader.readNext()) {
+        const QJsonStreamReader::TokenType token = reader.tokenType();
+        const int depth = reader.depth();
+        if (depth == 0)
+            continue;
+
+        if (reader.key(0) == QLatin1String("translation")) {
+            if (depth == 1 && token == QJsonStreamReader::String)
+                stream.result.translation.append(reader.text());
+            continue;
+        }
+
+        // Other fields are not used
+        if (reader.key(0) != QLatin1String("info")) {
+            if (depth == 1 && (token == QJsonStreamReader::StartArray || token == QJsonStreamReader::StartObject))
+                reader.skipCurrentElement();
+            continue;
+        }
+
+        if (depth == 1)
+            continue;
+
+        const QLatin1String field = reader.key(1);
+        if (field == QLatin1String("pronunciation")) {
+            // {"translation": translit}
+            if (m_translationTranslitEnabled && depth == 3 && token == QJsonStreamReader::String && reader.key(2) == QLatin1String("translation"))
+                stream.result.translationTranslit.append(reader.text());
+        } else if (field == QLatin1String("extraTranslations") && m_translationOptionsEnabled) {
+            // [{"type": type of speech, "list": [{"word": word, "meanings": [translations]}, ...]}, ...]
+            if (depth == 4 && token == QJsonStreamReader::String && reader.key(3) == QLatin1String("type")) {
+                stream.typeOfSpeech = reader.text();
+            } else if (depth == 6 && token == QJsonStreamReader::String && reader.key(3) == QLatin1String("list") && reader.key(5) == QLatin1String("word")) {
+                stream.option.word = reader.text();
+            } else if (depth == 7 && token == QJsonStreamReader::String && reader.key(3) == QLatin1String("list") && reader.key(5) == QLatin1String("meanings")) {
+                stream.option.translations.append(reader.text());
+            } else if (depth == 5 && token == QJsonStreamReader::EndObject && reader.key(3) == QLatin1String("list")) {
+                stream.options.append(stream.option);
+                stream.option = {};
+            } else if (depth == 3 && token == QJsonStreamReader::EndObject) {
+                // Type can be received after the list
+                if (!stream.options.isEmpty())
+                    stream.result.translationOptions[stream.typeOfSpeech].append(stream.options);
+                stream.options.clear();
+                stream.typeOfSpeech.clear();
             }
+        } else if (field == QLatin1String("definitions") && m_examplesEnabled) {
+            // [{"type": type of speech, "list": [{"definition": definition, "example": example}, ...]}, ...]
+            if (depth == 4 && token == QJsonStreamReader::String && reader.key(3) == QLatin1String("type")) {
+                stream.typeOfSpeech = reader.text();
+            } else if (depth == 6 && token == QJsonStreamReader::String && reader.key(3) == QLatin1String("list")) {
+                if (reader.key(5) == QLatin1String("definition"))
+                    stream.example.description = reader.text();
+                else if (reader.key(5) == QLatin1String("example"))
+                    stream.example.example = reader.text();
+            } else if (depth == 5 && token == QJsonStreamReader::EndObject && reader.key(3) == QLatin1String("list")) {
+                stream.examples.append(stream.example);
+                stream.example = {};
+            } else if (depth == 3 && token == QJsonStreamReader::EndObject) {
+                if (!stream.examples.isEmpty())
+                    stream.result.examples[stream.typeOfSpeech].append(stream.examples);
+                stream.examples.clear();
+                stream.typeOfSpeech.clear();
+            }
+        } else if (depth == 2 && (token == QJsonStreamReader::StartArray || token == QJsonStreamReader::StartObject)) {
+            reader.skipCurrentElement();
         }
     }
+}
+
+void QOnlineTranslator::buildGooglePipeline()
+{
+    // Google sends translation, translit and dictionary in one request, that will be splitted into several by the translation limit
+    addPipelineStage(&QOnlineTranslator::requestGoogleTranslate, &QOnlineTranslator::parseGoogleTranslate, &QOnlineTranslator::m_source, s_googleTranslateLimit, maxConcurrentRequests(Google), true).readMethod = &QOnlineTranslator::readGoogleTranslate;
+}
+
+void QOnlineTranslator::buildGoogleDetectPipeline()
+{
+    addDetectionStage(&QOnlineTranslator::requestGoogleTranslate, &QOnlineTranslator::parseGoogleTranslate, s_googleTranslateLimit);
+}
+
+void QOnlineTranslator::buildYandexPipeline()
+{
+    addPipelineStage(&QOnlineTranslator::requestYandexTranslate, &QOnlineTranslator::parseYandexTranslate, &QOnlineTranslator::m_source, s_yandexTranslateLimit, maxConcurrentRequests(Yandex), true);
+
+    // Source translit and dictionary depend only on the source language, so they are requested together with translation if it is known.
+    // Otherwise they are requested after translation together with translation translit.
+    const bool sourceLangKnown = m_sourceLang != Auto;
+    bool parallel = sourceLangKnown;
+    if (m_sourceTranslitEnabled && m_batch == nullptr) {
+        PipelineStage &stage = addPipelineStage(&QOnlineTranslator::requestYandexSourceTranslit, &QOnlineTranslator::parseYandexSourceTranslit, &QOnlineTranslator::m_source, s_yandexTranslitLimit, maxConcurrentRequests(Yandex));
+        stage.parallel = parallel;
+        stage.optional = true;
+        stage.output = &QOnlineTranslator::m_sourceTranslit;
+        parallel = true;
+    }
+
+    if (m_translationOptionsEnabled && m_batch == nullptr && !isContainsSpace(m_source)) {
+        PipelineStage &stage = addPipelineStage(&QOnlineTranslator::requestYandexDictionary, &QOnlineTranslator::parseYandexDictionary, &QOnlineTranslator::m_source);
+        stage.parallel = parallel;
+        stage.optional = true;
+        parallel = true;
+    }
+
+    // Translation is read when the stage starts, after it was received
+    if (m_translationTranslitEnabled && m_batch == nullptr) {
+        PipelineStage &stage = addPipelineStage(&QOnlineTranslator::requestYandexTranslationTranslit, &QOnlineTranslator::parseYandexTranslationTranslit, &QOnlineTranslator::m_translation, s_yandexTranslitLimit, maxConcurrentRequests(Yandex));
+        stage.parallel = !sourceLangKnown && parallel;
+        stage.optional = true;
+        stage.output = &QOnlineTranslator::m_translationTranslit;
+    }
+}
+
+void QOnlineTranslator::buildYandexDetectPipeline()
+{
+    addDetectionStage(&QOnlineTranslator::requestYandexTranslate, &QOnlineTranslator::parseYandexTranslate, s_yandexTranslateLimit);
+}
+
+void QOnlineTranslator::buildBingPipeline()
+{
+    // Generate credentials from web version first to access API
+    if (s_bingKey.isEmpty() || s_bingToken.isEmpty())
+        addPipelineStage(&QOnlineTranslator::requestBingCredentials, &QOnlineTranslator::parseBingCredentials);
+
+    addPipelineStage(&QOnlineTranslator::requestBingTranslate, &QOnlineTranslator::parseBingTranslate, &QOnlineTranslator::m_source, s_bingTranslateLimit, maxConcurrentRequests(Bing), true);
+
+    if (m_translationOptionsEnabled && m_batch == nullptr && !isContainsSpace(m_source))
+        addPipelineStage(&QOnlineTranslator::requestBingDictionary, &QOnlineTranslator::parseBingDictionary, &QOnlineTranslator::m_source).optional = true;
+}
+
+void QOnlineTranslator::buildBingDetectPipeline()
+{
+    addDetectionStage(&QOnlineTranslator::requestBingTranslate, &QOnlineTranslator::parseBingTranslate, s_bingTranslateLimit);
+}
+
+void QOnlineTranslator::buildLibrePipeline()
+{
+    // Older servers reject "auto" source, so the language is detected first
+    if (m_libreDetectionFirst && m_sourceLang == Auto) {
+        addDetectionStage(&QOnlineTranslator::requestLibreLangDetection, &QOnlineTranslator::parseLibreLangDetection, s_libreTranslateLimit);
+        addPipelineStage(&QOnlineTranslator::requestLibreTranslate, &QOnlineTranslator::parseLibreTranslate, &QOnlineTranslator::m_source, s_libreTranslateLimit, maxConcurrentRequests(LibreTranslate), true);
+        return;
+    }
 
-    // Examples
-    if (m_examplesEnabled) {
-        for (const QJsonValueRef examplesData : jsonData.value(QStringLiteral("definitions")).toArray()) {
-            const QJsonObject examplesObject = examplesData.toObject();
-            const QString typeOfSpeech = examplesObject.value(QStringLiteral("type")).toString();
+    // Translation is requested with "auto" source, servers that support it return the detected language
+    addPipelineStage(&QOnlineTranslator::requestLibreTranslate, &QOnlineTranslator::parseLibreTranslate, &QOnlineTranslator::m_source, s_libreTranslateLimit, maxConcurrentRequests(LibreTranslate), true);
 
-            for (const QJsonValueRef exampleData : examplesObject.value("list").toArray()) {
-                const QJsonObject exampleObject = exampleData.toObject();
-                const QString example = exampleObject.value(QStringLiteral("example")).toString();
-                const QString definition = exampleObject.value(QStringLiteral("definition")).toString();
+    // Servers that accept "auto" source, but do not return the detected language, require a separate detection request.
+    // It will be skipped if the language is already known. Servers that reject "auto" source are handled by retryLibreDetection().
+    if (m_sourceLang == Auto)
+        addDetectionStage(&QOnlineTranslator::requestLibreLangDetection, &QOnlineTranslator::parseLibreLangDetection, s_libreTranslateLimit);
+}
+
+void QOnlineTranslator::buildLibreDetectPipeline()
+{
+    addDetectionStage(&QOnlineTranslator::requestLibreLangDetection, &QOnlineTranslator::parseLibreLangDetection, s_libreTranslateLimit);
+}
+
+void QOnlineTranslator::buildLingvaPipeline()
+{
+    addPipelineStage(&QOnlineTranslator::requestLingvaTranslate, &QOnlineTranslator::parseLingvaTranslate, &QOnlineTranslator::m_source, s_googleTranslateLimit, maxConcurrentRequests(Lingva), true).readMethod = &QOnlineTranslator::readLingvaTranslate;
+}
+
+void QOnlineTranslator::buildLingvaDetectPipeline()
+{
+    addDetectionStage(&QOnlineTranslator::requestLingvaTranslate, &QOnlineTranslator::parseLingvaTranslate, s_googleTranslateLimit);
+}
 
-                m_examples[typeOfSpeech].append({example, definition});
+QOnlineTranslator::PipelineStage &QOnlineTranslator::addPipelineStage(QNetworkReply *(QOnlineTranslator::*requestMethod)(const QString &), void (QOnlineTranslator::*parseMethod)(QNetworkReply *), QString QOnlineTranslator::*text, int textLimit, int maxRequests, bool cacheSegments)
+{
+    m_pipeline->stages.append({requestMethod, parseMethod, text, textLimit, maxRequests, false, cacheSegments});
+    return m_pipeline->stages.last();
+}
+
+void QOnlineTranslator::addDetectionStage(QNetworkReply *(QOnlineTranslator::*requestMethod)(const QString &), void (QOnlineTranslator::*parseMethod)(QNetworkReply *), int textLimit)
+{
+    // Only the first part is enough to detect the language
+    m_pipeline->stages.append({requestMethod, parseMethod, &QOnlineTranslator::m_source, textLimit, 1, true, false});
+}
+
+void QOnlineTranslator::startPipeline()
+{
+    // Start on the next event loop iteration like the other asynchronous operations
+    m_pipelineTimer->start();
+    m_pipelineDuration.start();
+}
+
+void QOnlineTranslator::startPipelineStep(const std::shared_ptr<Pipeline> &pipeline)
+{
+    if (pipeline->nextStage == pipeline->stages.size()) {
+        m_pipeline.reset();
+        reportEngineResult(pipeline->engine, true);
+        if (!m_onlyDetectLanguage)
+            addDuration(pipeline->engine, m_pipelineDuration.elapsed());
+        cacheResult();
+        finishTranslation();
+        return;
+    }
+
+    // Parallel stages are started together with the previous one
+    const int firstStage = pipeline->nextStage;
+    do {
+        ++pipeline->nextStage;
+    } while (pipeline->nextStage < pipeline->stages.size() && pipeline->stages.at(pipeline->nextStage).parallel);
+
+    // Count all stages first because a stage can finish immediately
+    const int lastStage = pipeline->nextStage;
+    pipeline->activeStages = lastStage - firstStage;
+    for (int i = firstStage; i < lastStage; ++i) {
+        startPipelineStage(pipeline, i);
+
+        // Pipeline was stopped by an error
+        if (pipeline != m_pipeline)
+            return;
+    }
+}
+
+void QOnlineTranslator::startPipelineStage(const std::shared_ptr<Pipeline> &pipeline, int stageIndex)
+{
+    PipelineStage &stage = pipeline->stages[stageIndex];
+
+    // Additional data is not requested if the rest of the deadline is shorter than the time already spent
+    const int remaining = remainingTime();
+    if (stage.optional && remaining != -1 && remaining < m_deadline - remaining) {
+        processPipelineStage(pipeline, stageIndex);
+        return;
+    }
+
+    // Text is read only now, so it can contain data from the previous stages
+    stage.partsText = stage.text != nullptr ? this->*stage.text : QString();
+    const QString &text = stage.partsText;
+    if (stage.textLimit == 0)
+        stage.parts.append({0, text.size()});
+    else if (stage.onlyFirstPart)
+        stage.parts.append({0, QTextSplitter::splitIndex(text.constData(), text.size(), stage.textLimit)});
+    else
+        stage.parts = QTextSplitter::split(text, stage.textLimit);
+
+    // Short texts are cached as a whole
+    stage.cacheSegments = stage.cacheSegments && text.size() > stage.textLimit;
+
+    stage.replies.resize(stage.parts.size());
+    stage.finishedParts.resize(stage.parts.size());
+    stage.retryCounts.resize(stage.parts.size());
+    stage.timedOutParts.resize(stage.parts.size());
+
+    processPipelineStage(pipeline, stageIndex);
+}
+
+void QOnlineTranslator::processPipelineStage(const std::shared_ptr<Pipeline> &pipeline, int stageIndex)
+{
+    PipelineStage &stage = pipeline->stages[stageIndex];
+    forever {
+        // Parse finished parts in the original order
+        while (stage.parsedCount < stage.sentCount && stage.finishedParts.at(stage.parsedCount)) {
+            const int index = stage.parsedCount++;
+            const QPointer<QNetworkReply> reply = stage.replies.at(index);
+            if (reply == nullptr) {
+                const auto it = stage.cachedParts.constFind(index);
+                if (it != stage.cachedParts.cend())
+                    appendSegment(it.value());
+                continue;
+            }
+
+            if (stage.cacheSegments)
+                parseSegment(stage.parseMethod, reply, stage.part(index));
+            else
+                (this->*stage.parseMethod)(reply);
+
+            // Pipeline was stopped by resetData()
+            if (m_error != NoError) {
+                if (stage.timedOutParts.at(index))
+                    resetData(TimeoutError, tr("Request timed out"));
+                if (!m_aborting && m_error != ParametersError)
+                    reportEngineResult(pipeline->engine, false);
+                finishTranslation();
+                return;
+            }
+        }
+
+        if (stage.parsedCount == stage.parts.size()) {
+            if (--pipeline->activeStages == 0)
+                startPipelineStep(pipeline);
+            return;
+        }
+
+        if (stage.activeCount == stage.maxRequests || stage.sentCount == stage.parts.size() || stage.rateWaiting)
+            return;
+
+        // Send the next part
+        const int index = stage.sentCount;
+        TranslationResult segment;
+        if (stage.cacheSegments && findSegment(stage.part(index), segment)) {
+            ++stage.sentCount;
+            stage.cachedParts.insert(index, segment);
+            stage.finishedParts[index] = true;
+            continue;
+        }
+
+        // Requests over the rate limit continue from the timer, the object can be destroyed before it
+        if (!stage.rateReserved) {
+            const qint64 delay = reserveRequest(pipeline->engine, pipeline->host);
+            if (delay > 0) {
+                stage.rateReserved = true;
+                stage.rateWaiting = true;
+                QTimer::singleShot(static_cast<int>(delay), [translator = QPointer<QOnlineTranslator>(this), pipeline, stageIndex] {
+                    finishWaiting(pipeline->engine, pipeline->host);
+                    if (translator == nullptr || pipeline != translator->m_pipeline)
+                        return;
+
+                    pipeline->stages[stageIndex].rateWaiting = false;
+                    translator->processPipelineStage(pipeline, stageIndex);
+                });
+                return;
             }
         }
+        stage.rateReserved = false;
+        ++stage.sentCount;
+
+        if (!sendPipelinePart(pipeline, stageIndex, index))
+            stage.finishedParts[index] = true;
     }
 }
 
-void QOnlineTranslator::buildGoogleStateMachine()
+bool QOnlineTranslator::sendPipelinePart(const std::shared_ptr<Pipeline> &pipeline, int stageIndex, int index)
 {
-    // States (Google sends translation, translit and dictionary in one request, that will be splitted into several by the translation limit)
-    auto *translationState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(translationState);
+    PipelineStage &stage = pipeline->stages[stageIndex];
+    QNetworkReply *reply = (this->*stage.requestMethod)(stage.part(index));
+    stage.replies[index] = reply;
+    if (reply == nullptr)
+        return false;
 
-    translationState->addTransition(translationState, &QState::finished, finalState);
+    ++stage.activeCount;
+    m_replies.append(reply);
+    depositRetryBudget(pipeline->engine);
 
-    // Setup translation state
-    buildSplitNetworkRequest(translationState, &QOnlineTranslator::requestGoogleTranslate, &QOnlineTranslator::parseGoogleTranslate, m_source, s_googleTranslateLimit);
+    // Stalled requests are aborted, the timer is removed together with the reply
+    stage.timedOutParts[index] = false;
+    if (m_requestTimeout > 0) {
+        QTimer::singleShot(m_requestTimeout, reply, [pipeline, stageIndex, index, reply] {
+            if (reply->isFinished())
+                return;
+
+            pipeline->stages[stageIndex].timedOutParts[index] = true;
+            reply->abort();
+        });
+    }
+    if (stage.readMethod != nullptr) {
+        connect(reply, &QNetworkReply::readyRead, this, [this, pipeline, stageIndex, reply] {
+            // Replies of stopped pipelines are ignored
+            if (pipeline != m_pipeline)
+                return;
+
+            ReplyStream &stream = pipeline->streams[reply];
+            stream.addData(reply->readAll());
+            (this->*pipeline->stages.at(stageIndex).readMethod)(stream);
+        });
+    }
+    connect(reply, &QNetworkReply::finished, this, [this, pipeline, stageIndex, index, reply] {
+        // Replies of stopped pipelines are ignored
+        if (pipeline != m_pipeline)
+            return;
+
+        PipelineStage &stage = pipeline->stages[stageIndex];
+        --stage.activeCount;
+        if (retryPipelinePart(pipeline, stageIndex, index, reply))
+            return;
+
+        stage.finishedParts[index] = true;
+        processPipelineStage(pipeline, stageIndex);
+    });
+
+    return true;
 }
 
-void QOnlineTranslator::buildGoogleDetectStateMachine()
+bool QOnlineTranslator::retryPipelinePart(const std::shared_ptr<Pipeline> &pipeline, int stageIndex, int index, QNetworkReply *reply)
 {
-    // States
-    auto *detectState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(detectState);
+    PipelineStage &stage = pipeline->stages[stageIndex];
+    if (m_aborting || !(stage.timedOutParts.at(index) || isTransientError(reply)) || stage.retryCounts.at(index) == s_maxRetries || !withdrawRetryBudget(pipeline->engine))
+        return false;
 
-    detectState->addTransition(detectState, &QState::finished, finalState);
+    // The failed reply is not parsed, so the already received parts are kept
+    pipeline->streams.remove(reply);
+    m_replies.removeOne(reply);
+    reply->deleteLater();
+
+    // Full jitter spreads retries of all objects over the backoff interval
+    static thread_local std::mt19937 generator(std::random_device{}());
+    const int backoff = qMin(s_retryBaseDelay << stage.retryCounts.at(index), s_retryMaxDelay);
+    const int jitter = std::uniform_int_distribution<int>(0, backoff)(generator);
+    const qint64 rateDelay = reserveRequest(pipeline->engine, pipeline->host);
+    ++stage.retryCounts[index];
+
+    // The part keeps its place among simultaneous requests while waiting
+    ++stage.activeCount;
+    QTimer::singleShot(static_cast<int>(jitter + rateDelay), [translator = QPointer<QOnlineTranslator>(this), pipeline, stageIndex, index, rateDelay] {
+        if (rateDelay > 0)
+            finishWaiting(pipeline->engine, pipeline->host);
+        if (translator == nullptr || pipeline != translator->m_pipeline)
+            return;
 
-    // Setup detect state
-    const QString text = m_source.left(getSplitIndex(m_source, s_googleTranslateLimit));
-    buildNetworkRequestState(detectState, &QOnlineTranslator::requestGoogleTranslate, &QOnlineTranslator::parseGoogleTranslate, text);
+        PipelineStage &stage = pipeline->stages[stageIndex];
+        --stage.activeCount;
+        if (!translator->sendPipelinePart(pipeline, stageIndex, index)) {
+            stage.finishedParts[index] = true;
+            translator->processPipelineStage(pipeline, stageIndex);
+        }
+    });
+
+    return true;
 }
 
-void QOnlineTranslator::buildYandexStateMachine()
+bool QOnlineTranslator::isTransientError(QNetworkReply *reply)
 {
-    // States
-    auto *translationState = new QState(m_stateMachine);
-    auto *sourceTranslitState = new QState(m_stateMachine);
-    auto *translationTranslitState = new QState(m_stateMachine);
-    auto *dictionaryState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(translationState);
+    switch (reply->error()) {
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::ServiceUnavailableError:
+        return true;
+    default:
+        break;
+    }
 
-    // Transitions
-    translationState->addTransition(translationState, &QState::finished, sourceTranslitState);
-    sourceTranslitState->addTransition(sourceTranslitState, &QState::finished, translationTranslitState);
-    translationTranslitState->addTransition(translationTranslitState, &QState::finished, dictionaryState);
-    dictionaryState->addTransition(dictionaryState, &QState::finished, finalState);
+    // Too many requests, bad gateway, service unavailable and gateway timeout
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    return status == 429 || status == 502 || status == 503 || status == 504;
+}
 
-    // Setup translation state
-    buildSplitNetworkRequest(translationState, &QOnlineTranslator::requestYandexTranslate, &QOnlineTranslator::parseYandexTranslate, m_source, s_yandexTranslateLimit);
+void QOnlineTranslator::depositRetryBudget(Engine engine)
+{
+    QMutexLocker locker(&s_retryBudgetsMutex);
+    const auto it = s_retryBudgets.find(engine);
+    if (it != s_retryBudgets.end())
+        it.value() = qMin(it.value() + s_retryBudgetRatio, s_maxRetryBudget);
+}
 
-    // Setup source translit state
-    if (m_sourceTranslitEnabled)
-        buildSplitNetworkRequest(sourceTranslitState, &QOnlineTranslator::requestYandexSourceTranslit, &QOnlineTranslator::parseYandexSourceTranslit, m_source, s_yandexTranslitLimit);
-    else
-        sourceTranslitState->setInitialState(new QFinalState(sourceTranslitState));
+bool QOnlineTranslator::withdrawRetryBudget(Engine engine)
+{
+    QMutexLocker locker(&s_retryBudgetsMutex);
+    auto it = s_retryBudgets.find(engine);
+    if (it == s_retryBudgets.end())
+        it = s_retryBudgets.insert(engine, s_maxRetryBudget);
 
-    // Setup translation translit state
-    if (m_translationTranslitEnabled)
-        buildSplitNetworkRequest(translationTranslitState, &QOnlineTranslator::requestYandexTranslationTranslit, &QOnlineTranslator::parseYandexTranslationTranslit, m_translation, s_yandexTranslitLimit);
-    else
-        translationTranslitState->setInitialState(new QFinalState(translationTranslitState));
+    if (it.value() < 1)
+        return false;
 
-    // Setup dictionary state
-    if (m_translationOptionsEnabled && !isContainsSpace(m_source))
-        buildNetworkRequestState(dictionaryState, &QOnlineTranslator::requestYandexDictionary, &QOnlineTranslator::parseYandexDictionary, m_source);
-    else
-        dictionaryState->setInitialState(new QFinalState(dictionaryState));
+    it.value() -= 1;
+    return true;
 }
 
-void QOnlineTranslator::buildYandexDetectStateMachine()
+void QOnlineTranslator::stopPipeline()
 {
-    // States
-    auto *detectState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(detectState);
+    m_pipelineTimer->stop();
+    if (m_pipeline == nullptr)
+        return;
 
-    // Transitions
-    detectState->addTransition(detectState, &QState::finished, finalState);
+    // Reset first, so aborted replies will be ignored
+    const std::shared_ptr<Pipeline> pipeline = std::move(m_pipeline);
+    for (const PipelineStage &stage : pipeline->stages) {
+        for (int i = stage.parsedCount; i < stage.sentCount; ++i) {
+            const QPointer<QNetworkReply> reply = stage.replies.at(i);
+            if (reply != nullptr) {
+                reply->abort();
+                reply->deleteLater();
+            }
+        }
+    }
+}
 
-    // Setup detect state
-    const QString text = m_source.left(getSplitIndex(m_source, s_yandexTranslateLimit));
-    buildNetworkRequestState(detectState, &QOnlineTranslator::requestYandexTranslate, &QOnlineTranslator::parseYandexTranslate, text);
+bool QOnlineTranslator::hasOnlyOptionalStages(const std::shared_ptr<Pipeline> &pipeline)
+{
+    for (int i = 0; i < pipeline->stages.size(); ++i) {
+        const PipelineStage &stage = pipeline->stages.at(i);
+        const bool finished = i < pipeline->nextStage && stage.parsedCount == stage.parts.size();
+        if (!finished && !stage.optional)
+            return false;
+    }
+
+    return true;
 }
 
-void QOnlineTranslator::buildBingStateMachine()
+bool QOnlineTranslator::TranslationKey::operator==(const TranslationKey &other) const
 {
-    // States
-    auto *credentialsState = new QState(m_stateMachine); // Generate credentials from web version first to access API
-    auto *translationState = new QState(m_stateMachine);
-    auto *dictionaryState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(credentialsState);
+    return engine == other.engine
+        && sourceLang == other.sourceLang
+        && translationLang == other.translationLang
+        && uiLang == other.uiLang
+        && features == other.features
+        && text == other.text;
+}
 
-    // Transitions
-    credentialsState->addTransition(credentialsState, &QState::finished, translationState);
-    translationState->addTransition(translationState, &QState::finished, dictionaryState);
-    dictionaryState->addTransition(dictionaryState, &QState::finished, finalState);
+QOnlineTranslator::TranslationResult QOnlineTranslator::result() const
+{
+    return {m_sourceLang, m_translation, m_translationTranslit, m_sourceTranslit, m_sourceTranscription, m_translationOptions, m_examples};
+}
 
-    // Setup credentials state
-    if (s_bingKey.isEmpty() || s_bingToken.isEmpty())
-        buildNetworkRequestState(credentialsState, &QOnlineTranslator::requestBingCredentials, &QOnlineTranslator::parseBingCredentials);
-    else
-        credentialsState->setInitialState(new QFinalState(credentialsState));
+void QOnlineTranslator::setResult(const TranslationResult &result)
+{
+    m_sourceLang = result.sourceLang;
+    m_translation = result.translation;
+    m_translationTranslit = result.translationTranslit;
+    m_sourceTranslit = result.sourceTranslit;
+    m_sourceTranscription = result.sourceTranscription;
+    m_translationOptions = result.translationOptions;
+    m_examples = result.examples;
+}
 
-    // Setup translation state
-    buildSplitNetworkRequest(translationState, &QOnlineTranslator::requestBingTranslate, &QOnlineTranslator::parseBingTranslate, m_source, s_bingTranslateLimit);
+void QOnlineTranslator::cacheResult()
+{
+    if (m_cache != nullptr && m_batch == nullptr && m_error == NoError && !m_onlyDetectLanguage)
+        m_cache->insert(m_key, result());
+}
 
-    // Setup dictionary state
-    if (m_translationOptionsEnabled && !isContainsSpace(m_source))
-        buildNetworkRequestState(dictionaryState, &QOnlineTranslator::requestBingDictionary, &QOnlineTranslator::parseBingDictionary, m_source);
-    else
-        dictionaryState->setInitialState(new QFinalState(dictionaryState));
+QOnlineTranslator::TranslationKey QOnlineTranslator::segmentKey(const QString &text) const
+{
+    TranslationKey key = m_key;
+    key.features |= s_segmentKeyFlag;
+    key.text = text;
+    return key;
+}
+
+bool QOnlineTranslator::findSegment(const QString &text, TranslationResult &segment)
+{
+    if (m_cache == nullptr || m_batch != nullptr)
+        return false;
+
+    return m_cache->find(segmentKey(text), segment);
 }
 
-void QOnlineTranslator::buildBingDetectStateMachine()
+void QOnlineTranslator::appendSegment(const TranslationResult &segment)
 {
-    // States
-    auto *detectState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(detectState);
+    if (m_sourceLang == Auto)
+        m_sourceLang = segment.sourceLang;
 
-    detectState->addTransition(detectState, &QState::finished, finalState);
+    // Google parser separates parts with spaces
+    if (m_key.engine == Google) {
+        addSpaceBetweenParts(m_translation);
+        addSpaceBetweenParts(m_translationTranslit);
+        addSpaceBetweenParts(m_sourceTranslit);
+    }
 
-    // Setup translation state
-    const QString text = m_source.left(getSplitIndex(m_source, s_bingTranslateLimit));
-    buildNetworkRequestState(detectState, &QOnlineTranslator::requestBingTranslate, &QOnlineTranslator::parseBingTranslate, text);
+    m_translation.append(segment.translation);
+    m_translationTranslit.append(segment.translationTranslit);
+    m_sourceTranslit.append(segment.sourceTranslit);
 }
 
-void QOnlineTranslator::buildLibreStateMachine()
+void QOnlineTranslator::parseSegment(void (QOnlineTranslator::*parseMethod)(QNetworkReply *), QNetworkReply *reply, const QString &text)
 {
-    // States
-    auto *languageDetectionState = new QState(m_stateMachine);
-    auto *translationState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(languageDetectionState);
+    // Separators are added by appendSegment(), so they are not stored
+    if (m_key.engine == Google) {
+        addSpaceBetweenParts(m_translation);
+        addSpaceBetweenParts(m_translationTranslit);
+        addSpaceBetweenParts(m_sourceTranslit);
+    }
 
-    // Transitions
-    languageDetectionState->addTransition(languageDetectionState, &QState::finished, translationState);
-    translationState->addTransition(translationState, &QState::finished, finalState);
+    const int translationSize = m_translation.size();
+    const int translationTranslitSize = m_translationTranslit.size();
+    const int sourceTranslitSize = m_sourceTranslit.size();
 
-    // Setup LibreTranslate lang code detection
-    buildNetworkRequestState(languageDetectionState, &QOnlineTranslator::requestLibreLangDetection, &QOnlineTranslator::parseLibreLangDetection, m_source);
+    (this->*parseMethod)(reply);
+    if (m_error != NoError || m_cache == nullptr || m_batch != nullptr)
+        return;
 
-    // Setup translation state
-    buildSplitNetworkRequest(translationState, &QOnlineTranslator::requestLibreTranslate, &QOnlineTranslator::parseLibreTranslate, m_source, s_libreTranslateLimit);
+    TranslationResult segment;
+    segment.sourceLang = m_sourceLang;
+    segment.translation = m_translation.mid(translationSize);
+    segment.translationTranslit = m_translationTranslit.mid(translationTranslitSize);
+    segment.sourceTranslit = m_sourceTranslit.mid(sourceTranslitSize);
+    m_cache->insert(segmentKey(text), segment);
 }
 
-void QOnlineTranslator::buildLibreDetectStateMachine()
+QOnlineTranslator::ReplyStream QOnlineTranslator::takeReplyStream(QNetworkReply *reply)
 {
-    // States
-    auto *detectState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(detectState);
+    // Replies of stages without read method have no stream
+    ReplyStream stream = m_pipeline->streams.take(reply);
+    stream.addData(reply->readAll());
+    return stream;
+}
 
-    detectState->addTransition(detectState, &QState::finished, finalState);
+void QOnlineTranslator::appendDictionary(const TranslationResult &result)
+{
+    for (auto it = result.translationOptions.cbegin(); it != result.translationOptions.cend(); ++it)
+        m_translationOptions[it.key()].append(it.value());
 
-    // Setup lang detection state
-    const QString text = m_source.left(getSplitIndex(m_source, s_libreTranslateLimit));
-    buildNetworkRequestState(detectState, &QOnlineTranslator::requestLibreLangDetection, &QOnlineTranslator::parseLibreLangDetection, text);
+    for (auto it = result.examples.cbegin(); it != result.examples.cend(); ++it)
+        m_examples[it.key()].append(it.value());
 }
 
-void QOnlineTranslator::buildLingvaStateMachine()
+void QOnlineTranslator::translateBatchGroup(const std::shared_ptr<BatchRequest> &batch)
 {
-    // States
-    auto *translationState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(translationState);
+    // Another translation was started
+    if (batch != m_batch)
+        return;
 
-    // Transitions
-    translationState->addTransition(translationState, &QState::finished, finalState);
+    ++batch->currentGroup;
+    if (batch->aborted || batch->currentGroup == batch->groups.size()) {
+        m_batch.reset();
+        m_deadlineTimer->stop();
+        emit finished();
+        return;
+    }
 
-    // Setup translation state
-    buildSplitNetworkRequest(translationState, &QOnlineTranslator::requestLingvaTranslate, &QOnlineTranslator::parseLingvaTranslate, m_source, s_googleTranslateLimit);
+    QStringList texts;
+    for (int index : batch->groups.at(batch->currentGroup))
+        texts.append(batch->sources.at(index));
+
+    startTranslation(texts.join(s_batchSeparator), batch->engine, batch->translationLang, batch->sourceLang, batch->uiLang);
 }
 
-void QOnlineTranslator::buildLingvaDetectStateMachine()
+bool QOnlineTranslator::joinFlight()
 {
-    // States
-    auto *detectState = new QState(m_stateMachine);
-    auto *finalState = new QFinalState(m_stateMachine);
-    m_stateMachine->setInitialState(detectState);
+    QString engineUrl;
+    if (m_key.engine == LibreTranslate)
+        engineUrl = m_libreUrl + '#' + m_libreApiKey;
+    else if (m_key.engine == Lingva)
+        engineUrl = m_lingvaUrl;
 
-    detectState->addTransition(detectState, &QState::finished, finalState);
+    QMutexLocker locker(&s_flightsMutex);
+    const auto it = s_flights.find(m_key);
+    if (it == s_flights.end()) {
+        s_flights.insert(m_key, {this, engineUrl, {}});
+        m_flightKey = m_key;
+        m_flightLeader = true;
+        return false;
+    }
 
-    // Setup lang detection state
-    const QString text = m_source.left(getSplitIndex(m_source, s_googleTranslateLimit));
-    buildNetworkRequestState(detectState, &QOnlineTranslator::requestLingvaTranslate, &QOnlineTranslator::parseLingvaTranslate, text);
+    // Another instance, send own requests without affecting the flight
+    if (it->engineUrl != engineUrl)
+        return false;
+
+    m_flightKey = m_key;
+    m_followerId = ++s_lastFollowerId;
+    it->followers.append({this, m_followerId});
+    return true;
 }
 
-void QOnlineTranslator::buildSplitNetworkRequest(QState *parent, void (QOnlineTranslator::*requestMethod)(), void (QOnlineTranslator::*parseMethod)(), const QString &text, int textLimit)
+void QOnlineTranslator::leaveFlight()
 {
-    QString unsendedText = text;
-    auto *nextTranslationState = new QState(parent);
-    parent->setInitialState(nextTranslationState);
+    if (!m_flightLeader && m_followerId == 0)
+        return;
 
-    while (!unsendedText.isEmpty()) {
-        auto *currentTranslationState = nextTranslationState;
-        nextTranslationState = new QState(parent);
+    m_flightLeader = false;
+    m_followerId = 0;
 
-        // Do not translate the part if it looks like garbage
-        const int splitIndex = getSplitIndex(unsendedText, textLimit);
-        if (splitIndex == -1) {
-            currentTranslationState->setProperty(s_textProperty, unsendedText.left(textLimit));
-            currentTranslationState->addTransition(nextTranslationState);
-            connect(currentTranslationState, &QState::entered, this, &QOnlineTranslator::skipGarbageText);
+    QMutexLocker locker(&s_flightsMutex);
+    const auto it = s_flights.find(m_flightKey);
+    if (it == s_flights.end())
+        return;
 
-            // Remove the parsed part from the next parsing
-            unsendedText = unsendedText.mid(textLimit);
-        } else {
-            buildNetworkRequestState(currentTranslationState, requestMethod, parseMethod, unsendedText.left(splitIndex));
-            currentTranslationState->addTransition(currentTranslationState, &QState::finished, nextTranslationState);
+    if (it->leader != this) {
+        for (int i = 0; i < it->followers.size(); ++i) {
+            if (it->followers.at(i).translator == this) {
+                it->followers.remove(i);
+                break;
+            }
+        }
+        return;
+    }
+
+    if (it->followers.isEmpty()) {
+        s_flights.erase(it);
+        return;
+    }
+
+    // Scheduled while the mutex is locked, so the follower cannot be destroyed in between
+    const Follower next = it->followers.takeFirst();
+    it->leader = next.translator;
+    QTimer::singleShot(0, next.translator, [translator = next.translator, id = next.id] {
+        translator->takeOverFlight(id);
+    });
+}
+
+void QOnlineTranslator::takeOverFlight(quint64 flightId)
+{
+    // The follower was aborted after it was chosen, the flight was passed further
+    if (m_followerId != flightId)
+        return;
 
-            // Remove the parsed part from the next parsing
-            unsendedText = unsendedText.mid(splitIndex);
+    m_followerId = 0;
+    m_flightLeader = true;
+    startEnginePipeline();
+}
+
+void QOnlineTranslator::finishFlight()
+{
+    if (!m_flightLeader)
+        return;
+
+    m_flightLeader = false;
+    const TranslationResult result = this->result();
+
+    QMutexLocker locker(&s_flightsMutex);
+    const Flight flight = s_flights.take(m_flightKey);
+    for (const Follower &follower : flight.followers) {
+        QTimer::singleShot(0, follower.translator, [translator = follower.translator, id = follower.id, result, error = m_error, errorString = m_errorString] {
+            translator->finishFollowing(id, result, error, errorString);
+        });
+    }
+}
+
+void QOnlineTranslator::finishFollowing(quint64 flightId, const TranslationResult &result, TranslationError error, const QString &errorString)
+{
+    // Results that arrive after abort are ignored
+    if (m_followerId != flightId)
+        return;
+
+    m_followerId = 0;
+    if (error == NoError)
+        setResult(result);
+    else
+        resetData(error, errorString);
+
+    // The leader already tried the failover engines
+    m_enginePosition = m_engineChain.size();
+    finishTranslation();
+}
+
+int QOnlineTranslator::availableEnginePosition(int position) const
+{
+    for (int i = position; i < m_engineChain.size(); ++i) {
+        const Engine engine = m_engineChain.at(i);
+
+        // The selected engine reports parameter errors as usual, failover engines are used only if they can translate
+        if (i != 0) {
+            if (!isSupportTranslation(engine, m_sourceLang) || !isSupportTranslation(engine, m_translationLang) || !isSupportTranslation(engine, m_uiLang))
+                continue;
+            if ((engine == LibreTranslate && m_libreUrl.isEmpty()) || (engine == Lingva && m_lingvaUrl.isEmpty()))
+                continue;
         }
+
+        if (isEngineAvailable(engine))
+            return i;
     }
 
-    nextTranslationState->addTransition(new QFinalState(parent));
+    return -1;
 }
 
-void QOnlineTranslator::buildNetworkRequestState(QState *parent, void (QOnlineTranslator::*requestMethod)(), void (QOnlineTranslator::*parseMethod)(), const QString &text)
+bool QOnlineTranslator::failOver()
 {
-    // Network substates
-    auto *requestingState = new QState(parent);
-    auto *parsingState = new QState(parent);
+    if (m_batch != nullptr || m_onlyDetectLanguage || m_aborting)
+        return false;
 
-    parent->setInitialState(requestingState);
+    if (m_error != NetworkError && m_error != ServiceError && m_error != ParsingError && m_error != TimeoutError)
+        return false;
+
+    const int position = availableEnginePosition(m_enginePosition + 1);
+    if (position == -1)
+        return false;
 
-    // Substates transitions
-    requestingState->addTransition(m_networkManager, &QNetworkAccessManager::finished, parsingState);
-    parsingState->addTransition(new QFinalState(parent));
+    // Start from the found engine, all of them are checked again to use the current state of circuits
+    m_enginePosition = position;
+    const TranslationKey key = m_key;
+    startTranslation(key.text, m_engineChain.at(position), key.translationLang, key.sourceLang, key.uiLang);
+    return true;
+}
 
-    // Setup requesting state
-    requestingState->setProperty(s_textProperty, text);
-    connect(requestingState, &QState::entered, this, requestMethod);
+bool QOnlineTranslator::retryLibreDetection()
+{
+    if (!m_libreAutoRejected)
+        return false;
 
-    // Setup parsing state
-    connect(parsingState, &QState::entered, this, parseMethod);
+    m_libreAutoRejected = false;
+    if (m_error != ParametersError || m_aborting)
+        return false;
+
+    // Remembered for the next translations with this server
+    m_libreDetectionFirst = true;
+    resetData();
+    startEnginePipeline();
+    return true;
 }
 
-void QOnlineTranslator::requestYandexTranslit(Language language)
+bool QOnlineTranslator::acquireEngine(Engine engine) const
 {
-    // Check if language is supported (need to check here because language may be autodetected)
-    if (!isSupportTranslit(Yandex, language)) {
-        auto *state = qobject_cast<QState *>(sender());
-        state->addTransition(new QFinalState(state->parentState()));
+    QMutexLocker locker(&s_breakersMutex);
+    CircuitBreaker &breaker = s_breakers[engine];
+    if (breaker.state == CircuitBreaker::Closed)
+        return true;
+
+    // A new probe can be sent after the open duration, also if the previous one was lost
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - breaker.changedAt < s_breakerOpenDuration)
+        return false;
+
+    breaker.state = CircuitBreaker::HalfOpen;
+    breaker.changedAt = now;
+    breaker.probe = this;
+    return true;
+}
+
+void QOnlineTranslator::releaseEngine(Engine engine) const
+{
+    QMutexLocker locker(&s_breakersMutex);
+    const auto it = s_breakers.find(engine);
+    if (it != s_breakers.end() && it->state == CircuitBreaker::HalfOpen && it->probe == this) {
+        it->changedAt = 0;
+        it->probe = nullptr;
+    }
+}
+
+void QOnlineTranslator::reportEngineResult(Engine engine, bool success)
+{
+    QMutexLocker locker(&s_breakersMutex);
+    CircuitBreaker &breaker = s_breakers[engine];
+    if (breaker.failures.size() == s_breakerResultCount)
+        breaker.failures.removeFirst();
+    breaker.failures.append(!success);
+
+    if (success) {
+        breaker.consecutiveFailures = 0;
+        if (breaker.state == CircuitBreaker::HalfOpen) {
+            breaker.state = CircuitBreaker::Closed;
+            breaker.failures.clear();
+            breaker.probe = nullptr;
+        }
+        return;
+    }
+
+    ++breaker.consecutiveFailures;
+    const auto failureCount = std::count(breaker.failures.cbegin(), breaker.failures.cend(), true);
+    if (breaker.state == CircuitBreaker::HalfOpen
+        || breaker.consecutiveFailures >= s_breakerConsecutiveFailures
+        || (breaker.failures.size() >= s_breakerMinResultCount && failureCount >= breaker.failures.size() * s_breakerFailureRate)) {
+        breaker.state = CircuitBreaker::Open;
+        breaker.changedAt = QDateTime::currentMSecsSinceEpoch();
+        breaker.probe = nullptr;
+    }
+}
+
+void QOnlineTranslator::setRateLimit(RateLimit &limit, qreal rate, int burst)
+{
+    limit.interval = 1000 / rate;
+    limit.tolerance = (qMax(burst, 1) - 1) * limit.interval;
+}
+
+qint64 QOnlineTranslator::reserveRequest(Engine engine, const QString &host)
+{
+    QMutexLocker locker(&s_rateLimitsMutex);
+    RateLimit *limit = findRateLimit(engine, host);
+    if (limit == nullptr)
+        return 0;
+
+    // The request is allowed if it comes no earlier than the tolerance before its theoretical time
+    const auto now = static_cast<qreal>(QDateTime::currentMSecsSinceEpoch());
+    const qreal arrivalTime = qMax(limit->arrivalTime, now);
+    const auto delay = static_cast<qint64>(std::ceil(qMax<qreal>(arrivalTime - limit->tolerance - now, 0)));
+    limit->arrivalTime = arrivalTime + limit->interval;
+
+    if (delay > 0) {
+        ++limit->stats.queueSize;
+        ++limit->stats.delayedCount;
+        limit->stats.totalWaitTime += delay;
+        limit->stats.maxWaitTime = qMax(limit->stats.maxWaitTime, delay);
+    }
+
+    return delay;
+}
+
+void QOnlineTranslator::finishWaiting(Engine engine, const QString &host)
+{
+    QMutexLocker locker(&s_rateLimitsMutex);
+    RateLimit *limit = findRateLimit(engine, host);
+    if (limit != nullptr)
+        limit->stats.queueSize = qMax(limit->stats.queueSize - 1, 0);
+}
+
+QString QOnlineTranslator::instanceHost(Engine engine) const
+{
+    switch (engine) {
+    case LibreTranslate:
+        return QUrl(m_libreUrl).host();
+    case Lingva:
+        return QUrl(m_lingvaUrl).host();
+    default:
+        return {};
+    }
+}
+
+QOnlineTranslator::RateLimit *QOnlineTranslator::findRateLimit(Engine engine, const QString &host)
+{
+    if (!host.isEmpty()) {
+        const auto it = s_hostRateLimits.find(host);
+        if (it != s_hostRateLimits.end())
+            return &it.value();
+    }
+
+    const auto it = s_engineRateLimits.find(engine);
+    return it != s_engineRateLimits.end() ? &it.value() : nullptr;
+}
+
+void QOnlineTranslator::startHedge()
+{
+    if (m_pipeline == nullptr)
         return;
+
+    const TranslationKey &key = m_key;
+    if (!isSupportTranslation(m_hedgeEngine, key.sourceLang) || !isSupportTranslation(m_hedgeEngine, key.translationLang) || !isSupportTranslation(m_hedgeEngine, key.uiLang))
+        return;
+
+    if (m_hedgeTranslator == nullptr) {
+        m_hedgeTranslator = new QOnlineTranslator(this);
+        m_hedgeTranslator->m_requestCoalescingEnabled = false;
+        connect(m_hedgeTranslator, &QOnlineTranslator::finished, this, &QOnlineTranslator::finishHedge);
     }
 
-    const QString text = sender()->property(s_textProperty).toString();
+    // Use the same settings, except the cache, which is filled by this object
+    m_hedgeTranslator->setNetworkAccessManager(networkAccessManager());
+    m_hedgeTranslator->m_languageIdentifier = m_languageIdentifier;
+    m_hedgeTranslator->m_libreUrl = m_libreUrl;
+    m_hedgeTranslator->m_libreApiKey = m_libreApiKey;
+    m_hedgeTranslator->m_lingvaUrl = m_lingvaUrl;
+    m_hedgeTranslator->m_maxConcurrentRequests = m_maxConcurrentRequests;
+    m_hedgeTranslator->m_sourceTranslitEnabled = m_sourceTranslitEnabled;
+    m_hedgeTranslator->m_translationTranslitEnabled = m_translationTranslitEnabled;
+    m_hedgeTranslator->m_sourceTranscriptionEnabled = m_sourceTranscriptionEnabled;
+    m_hedgeTranslator->m_translationOptionsEnabled = m_translationOptionsEnabled;
+    m_hedgeTranslator->m_examplesEnabled = m_examplesEnabled;
+    m_hedgeTranslator->m_offlineTranslitEnabled = m_offlineTranslitEnabled;
+    m_hedgeTranslator->m_requestTimeout = m_requestTimeout; // The deadline of this object aborts the hedge engine
+
+    m_hedging = true;
+    m_hedgeTranslator->translate(key.text, m_hedgeEngine, key.translationLang, key.sourceLang, key.uiLang);
+}
+
+void QOnlineTranslator::stopHedge()
+{
+    m_hedgeTimer->stop();
+    if (!m_hedging)
+        return;
+
+    // Reset first, so the aborted translation will be ignored
+    m_hedging = false;
+    m_hedgeTranslator->abort();
+}
+
+void QOnlineTranslator::finishHedge()
+{
+    if (!m_hedging)
+        return;
+
+    m_hedging = false;
+    if (m_hedgeTranslator->m_error != NoError) {
+        // Wait for the selected engine, unless it also failed
+        if (m_pipeline == nullptr)
+            finishTranslation();
+        return;
+    }
+
+    // Aborts requests of the selected engine and ignores their replies
+    resetData();
+    releaseEngine(m_key.engine);
+    setResult(m_hedgeTranslator->result());
+    if (m_cache != nullptr)
+        m_cache->insert(m_hedgeTranslator->m_key, m_hedgeTranslator->result());
+    finishTranslation();
+}
+
+int QOnlineTranslator::hedgeDelay(Engine engine, qreal percentile)
+{
+    QMutexLocker locker(&s_durationsMutex);
+    QVector<qint64> durations = s_durations.value(engine);
+    locker.unlock();
+
+    if (durations.size() < s_minDurationCount)
+        return s_defaultHedgeDelay;
+
+    std::sort(durations.begin(), durations.end());
+    const int index = qBound(0, static_cast<int>(std::ceil(percentile * durations.size())) - 1, durations.size() - 1);
+    return static_cast<int>(durations.at(index));
+}
+
+void QOnlineTranslator::addDuration(Engine engine, qint64 duration)
+{
+    QMutexLocker locker(&s_durationsMutex);
+    QVector<qint64> &durations = s_durations[engine];
+    if (durations.size() == s_durationCount)
+        durations.removeFirst();
+    durations.append(duration);
+}
+
+void QOnlineTranslator::finishTranslation()
+{
+    // Failed requests are replaced by the hedge engine, if it succeeds
+    if (m_hedging && m_error != NoError)
+        return;
+    stopHedge();
+
+    if (retryLibreDetection() || failOver())
+        return;
+
+    finishFlight();
+
+    if (m_batch == nullptr) {
+        m_deadlineTimer->stop();
+        emit finished();
+        return;
+    }
+
+    // Translation finished before the first group was started
+    const std::shared_ptr<BatchRequest> batch = m_batch;
+    if (batch->currentGroup == -1)
+        return;
+
+    const QVector<int> group = batch->groups.at(batch->currentGroup);
+    if (m_error != NoError && group.size() > 1 && !batch->aborted && m_error != TimeoutError && m_error != ParametersError) {
+        // A single text could fail the whole group, translate texts of this group one by one to get their own errors
+        for (int index : group)
+            batch->groups.append(QVector<int>{index});
+    } else if (m_error != NoError) {
+        for (int index : group) {
+            m_batchTranslations[index].clear();
+            m_batchErrors[index] = m_error;
+            m_batchErrorStrings[index] = m_errorString;
+        }
+    } else if (group.size() == 1) {
+        m_batchTranslations[group.first()] = m_translation;
+    } else {
+        const QStringList translations = m_translation.trimmed().split(s_batchSeparator);
+        if (translations.size() == group.size()) {
+            for (int i = 0; i < group.size(); ++i)
+                m_batchTranslations[group.at(i)] = translations.at(i);
+        } else {
+            // The engine merged or splitted lines, translate texts of this group one by one
+            for (int index : group)
+                batch->groups.append(QVector<int>{index});
+        }
+    }
+
+    // Start the next group after the pipeline finishes processing
+    QTimer::singleShot(0, this, [this, batch] {
+        translateBatchGroup(batch);
+    });
+}
+
+QNetworkReply *QOnlineTranslator::requestYandexTranslit(Language language, const QString &text, QString &translit)
+{
+    // All parts of a stage have the same language, so local parts are appended in order like parsed replies
+    if (m_offlineTranslitEnabled && QTransliterator::isSupported(language)) {
+        translit += QTransliterator::transliterate(text, language);
+        return nullptr;
+    }
+
+    // Check if language is supported (need to check here because language may be autodetected)
+    if (!isSupportTranslit(Yandex, language))
+        return nullptr;
 
     // Generate API url
     QUrl url(QStringLiteral("https://translate.yandex.net/translit/translit"));
     url.setQuery("text=" + QUrl::toPercentEncoding(text)
-                 + "&lang=" + languageApiCode(Yandex, language));
+                 + "&lang=" + languageApiCode(Yandex, language).latin1());
 
-    m_currentReply = m_networkManager->get(QNetworkRequest(url));
+    return networkAccessManager()->get(QNetworkRequest(url));
 }
 
-void QOnlineTranslator::parseYandexTranslit(QString &text)
+void QOnlineTranslator::parseYandexTranslit(QNetworkReply *reply, QString &text)
 {
-    m_currentReply->deleteLater();
+    reply->deleteLater();
 
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        resetData(NetworkError, m_currentReply->errorString());
+    if (reply->error() != QNetworkReply::NoError) {
+        resetData(NetworkError, reply->errorString());
         return;
     }
 
-    const QByteArray reply = m_currentReply->readAll();
+    const QByteArray data = reply->readAll();
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-    text += reply.mid(1).chopped(1);
+    text += data.mid(1).chopped(1);
 #else
-    text += reply.mid(1);
+    text += data.mid(1);
     text.chop(1);
 #endif
 }
@@ -2054,411 +3245,187 @@ void QOnlineTranslator::resetData(TranslationError error, const QString &errorSt
     m_sourceTranscription.clear();
     m_translationOptions.clear();
     m_examples.clear();
-
-    m_stateMachine->stop();
-    for (QAbstractState *state : m_stateMachine->findChildren<QAbstractState *>()) {
-        if (!m_stateMachine->configuration().contains(state))
-            state->deleteLater();
-    }
+    m_replies.clear();
+    m_cachedFinishTimer->stop();
+    stopPipeline();
 }
 
 bool QOnlineTranslator::isSupportTranslit(Engine engine, Language lang)
 {
-    switch (engine) {
-    case Google:
-    case Lingva:
-        isSupportTranslation(Google, lang); // Google supports transliteration for all supported languages
-        break;
-    case Yandex:
-        switch (lang) {
-        case Amharic:
-        case Armenian:
-        case Bengali:
-        case SimplifiedChinese:
-        case Georgian:
-        case Greek:
-        case Gujarati:
-        case Hebrew:
-        case Hindi:
-        case Japanese:
-        case Kannada:
-        case Korean:
-        case Malayalam:
-        case Marathi:
-        case Nepali:
-        case Punjabi:
-        case Russian:
-        case Sinhala:
-        case Tamil:
-        case Telugu:
-        case Thai:
-        case Yiddish:
-            return true;
-        default:
-            return false;
-        }
-    case Bing:
-        switch (lang) {
-        case Arabic:
-        case Bengali:
-        case Gujarati:
-        case Hebrew:
-        case Hindi:
-        case Japanese:
-        case Kannada:
-        case Malayalam:
-        case Marathi:
-        case Punjabi:
-        case SerbianCyrillic:
-        case SerbianLatin:
-        case Tamil:
-        case Telugu:
-        case Thai:
-        case SimplifiedChinese:
-        case TraditionalChinese:
-            return true;
-        default:
-            return false;
-        }
-    case LibreTranslate: // LibreTranslate doesn't support translit
-        return false;
-    }
+    // Generated at compile time from hasTranslit()
+    static constexpr std::array<LanguageSet, s_engineCount> languages = {
+        makeLanguageSet([](Language checkedLang) { return hasTranslit(Google, checkedLang); }),
+        makeLanguageSet([](Language checkedLang) { return hasTranslit(Yandex, checkedLang); }),
+        makeLanguageSet([](Language checkedLang) { return hasTranslit(Bing, checkedLang); }),
+        makeLanguageSet([](Language checkedLang) { return hasTranslit(LibreTranslate, checkedLang); }),
+        makeLanguageSet([](Language checkedLang) { return hasTranslit(Lingva, checkedLang); }),
+    };
 
-    return false;
+    return contains(languages[engine], lang);
 }
 
 bool QOnlineTranslator::isSupportDictionary(Engine engine, Language sourceLang, Language translationLang)
 {
-    switch (engine) {
-    case Google:
-        return isSupportTranslation(Google, sourceLang) && isSupportTranslation(Google, translationLang); // Google supports dictionary for all supported languages
-    case Yandex:
-        switch (sourceLang) {
-        case Belarusian:
-            switch (translationLang) {
-            case Belarusian:
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case Bulgarian:
-            switch (translationLang) {
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case Czech:
-        case Danish:
-        case Dutch:
-        case Estonian:
-        case Greek:
-        case Latvian:
-        case Norwegian:
-        case Portuguese:
-        case Slovak:
-        case Swedish:
-            switch (translationLang) {
-            case English:
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case German:
-            switch (translationLang) {
-            case German:
-            case English:
-            case Russian:
-            case Turkish:
-                return true;
-            default:
-                return false;
-            }
-        case English:
-            switch (translationLang) {
-            case Czech:
-            case Danish:
-            case German:
-            case Greek:
-            case English:
-            case Spanish:
-            case Estonian:
-            case Finnish:
-            case French:
-            case Italian:
-            case Lithuanian:
-            case Latvian:
-            case Dutch:
-            case Norwegian:
-            case Portuguese:
-            case Russian:
-            case Slovak:
-            case Swedish:
-            case Turkish:
-            case Ukrainian:
-                return true;
-            default:
-                return false;
-            }
-        case Spanish:
-            switch (translationLang) {
-            case English:
-            case Spanish:
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case Finnish:
-            switch (translationLang) {
-            case English:
-            case Russian:
-            case Finnish:
-                return true;
-            default:
-                return false;
-            }
-        case French:
-            switch (translationLang) {
-            case French:
-            case English:
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case Hungarian:
-            switch (translationLang) {
-            case Hungarian:
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case Italian:
-            switch (translationLang) {
-            case English:
-            case Italian:
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case Lithuanian:
-            switch (translationLang) {
-            case English:
-            case Lithuanian:
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case Mari:
-        case HillMari:
-        case Polish:
-        case Tatar:
-            switch (translationLang) {
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case Russian:
-            switch (translationLang) {
-            case Belarusian:
-            case Bulgarian:
-            case Czech:
-            case Danish:
-            case German:
-            case Greek:
-            case English:
-            case Spanish:
-            case Estonian:
-            case Finnish:
-            case French:
-            case Italian:
-            case Lithuanian:
-            case Latvian:
-            case Mari:
-            case HillMari:
-            case Dutch:
-            case Norwegian:
-            case Portuguese:
-            case Russian:
-            case Slovak:
-            case Swedish:
-            case Turkish:
-            case Tatar:
-            case Ukrainian:
-                return true;
-            default:
-                return false;
-            }
-        case Turkish:
-            switch (translationLang) {
-            case German:
-            case English:
-            case Russian:
-                return true;
-            default:
-                return false;
-            }
-        case Ukrainian:
-            switch (translationLang) {
-            case English:
-            case Russian:
-            case Ukrainian:
-                return true;
-            default:
-                return false;
-            }
-        default:
-            return false;
+    // Generated at compile time from hasDictionary(), each engine is a separate constant to keep the evaluation small
+    static constexpr LanguagePairs googlePairs = makeLanguagePairs([](Language from, Language to) { return hasDictionary(Google, from, to); });
+    static constexpr LanguagePairs yandexPairs = makeLanguagePairs([](Language from, Language to) { return hasDictionary(Yandex, from, to); });
+    static constexpr LanguagePairs bingPairs = makeLanguagePairs([](Language from, Language to) { return hasDictionary(Bing, from, to); });
+    static constexpr LanguagePairs librePairs = makeLanguagePairs([](Language from, Language to) { return hasDictionary(LibreTranslate, from, to); });
+    static constexpr LanguagePairs lingvaPairs = makeLanguagePairs([](Language from, Language to) { return hasDictionary(Lingva, from, to); });
+    static constexpr std::array<const LanguagePairs *, s_engineCount> pairs = {&googlePairs, &yandexPairs, &bingPairs, &librePairs, &lingvaPairs};
+
+    return contains(pairs[engine]->at(languageIndex(sourceLang)), translationLang);
+}
+
+// Returns engine-specific language code for translation
+QLatin1String QOnlineTranslator::languageApiCode(Engine engine, Language lang)
+{
+    if (!isSupportTranslation(engine, lang))
+        return {};
+
+    const int index = languageIndex(lang);
+    const char *code = (*s_engineLanguageCodes[engine])[index];
+    return QLatin1String(code != nullptr ? code : s_genericLanguageCodes[index]);
+}
+
+// Returns language by the Unicode script of the text if the script is used only by this language, NoLanguage otherwise
+QOnlineTranslator::Language QOnlineTranslator::scriptLanguage(const QString &text)
+{
+    // Scripts that are used by a single supported language
+    static constexpr std::array<std::pair<QChar::Script, Language>, 18> scriptLanguages = {{
+        {QChar::Script_Armenian, Armenian},
+        {QChar::Script_Bengali, Bengali},
+        {QChar::Script_Ethiopic, Amharic},
+        {QChar::Script_Georgian, Georgian},
+        {QChar::Script_Greek, Greek},
+        {QChar::Script_Gujarati, Gujarati},
+        {QChar::Script_Gurmukhi, Punjabi},
+        {QChar::Script_Hebrew, Hebrew},
+        {QChar::Script_Kannada, Kannada},
+        {QChar::Script_Khmer, Khmer},
+        {QChar::Script_Lao, Lao},
+        {QChar::Script_Malayalam, Malayalam},
+        {QChar::Script_Myanmar, Myanmar},
+        {QChar::Script_Oriya, Oriya},
+        {QChar::Script_Sinhala, Sinhala},
+        {QChar::Script_Tamil, Tamil},
+        {QChar::Script_Telugu, Telugu},
+        {QChar::Script_Thai, Thai},
+    }};
+
+    // Percentage of letters that should be written in the script
+    constexpr int confidence = 80;
+
+    std::array<int, QChar::ScriptCount> scriptLetters{};
+    int letters = 0;
+    uint previous = 0;
+    for (int i = 0; i < text.size(); ++i) {
+        uint ucs4 = text.at(i).unicode();
+        if (text.at(i).isHighSurrogate() && i + 1 < text.size() && text.at(i + 1).isLowSurrogate())
+            ucs4 = QChar::surrogateToUcs4(text.at(i), text.at(++i));
+
+        if (!QChar::isLetter(ucs4)) {
+            previous = 0;
+            continue;
         }
-    case Bing:
-        // Bing support dictionary only to or from English
-        Language secondLang;
-        if (sourceLang == English)
-            secondLang = translationLang;
-        else if (translationLang == English)
-            secondLang = sourceLang;
-        else
-            return false;
 
-        switch (secondLang) {
-        case Afrikaans:
-        case Arabic:
-        case Bengali:
-        case Bosnian:
-        case Bulgarian:
-        case Catalan:
-        case SimplifiedChinese:
-        case Croatian:
-        case Czech:
-        case Danish:
-        case Dutch:
-        case Estonian:
-        case Finnish:
-        case French:
-        case German:
-        case Greek:
-        case HaitianCreole:
-        case Hebrew:
-        case Hindi:
-        case Hmong:
-        case Hungarian:
-        case Icelandic:
-        case Indonesian:
-        case Italian:
-        case Japanese:
-        case Swahili:
-        case Klingon:
-        case Korean:
-        case Latvian:
-        case Lithuanian:
-        case Malay:
-        case Maltese:
-        case Norwegian:
-        case Persian:
-        case Polish:
-        case Portuguese:
-        case Romanian:
-        case Russian:
-        case SerbianLatin:
-        case Slovak:
-        case Slovenian:
-        case Spanish:
-        case Swedish:
-        case Tamil:
-        case Thai:
-        case Turkish:
-        case Ukrainian:
-        case Urdu:
-        case Vietnamese:
-        case Welsh:
-            return true;
-        default:
-            return false;
+        // Yiddish ligatures and the double vav and yod that are often written instead of them, Hebrew script is ambiguous with them
+        if ((ucs4 >= 0x05F0 && ucs4 <= 0x05F2) || ucs4 == 0xFB1F || ucs4 == 0xFB2E || ucs4 == 0xFB2F)
+            return NoLanguage;
+        if ((ucs4 == 0x05D5 || ucs4 == 0x05D9) && ucs4 == previous)
+            return NoLanguage;
+        previous = ucs4;
+
+        ++scriptLetters[QChar::script(ucs4)];
+        ++letters;
+    }
+
+    if (letters == 0)
+        return NoLanguage;
+
+    Language lang = NoLanguage;
+    int langLetters = 0;
+    for (const auto &[script, scriptLang] : scriptLanguages) {
+        if (scriptLetters[script] > langLetters) {
+            lang = scriptLang;
+            langLetters = scriptLetters[script];
         }
-    case LibreTranslate: // LibreTranslate doesn't support dictinaries
-    case Lingva: // Although Lingvo is a frontend to Google Translate, it doesn't support dictionaries
-        return false;
     }
 
-    return false;
+    // Japanese kanji and Korean hanja are Han characters, which alone can also be Chinese
+    const int han = scriptLetters[QChar::Script_Han];
+    const int kana = scriptLetters[QChar::Script_Hiragana] + scriptLetters[QChar::Script_Katakana];
+    const int hangul = scriptLetters[QChar::Script_Hangul];
+    if (kana != 0 && kana + han > langLetters) {
+        lang = Japanese;
+        langLetters = kana + han;
+    }
+    if (hangul != 0 && hangul + han > langLetters) {
+        lang = Korean;
+        langLetters = hangul + han;
+    }
+
+    if (langLetters * 100 < letters * confidence)
+        return NoLanguage;
+
+    return lang;
 }
 
-// Returns engine-specific language code for translation
-QString QOnlineTranslator::languageApiCode(Engine engine, Language lang)
+QOnlineTranslator::Language QOnlineTranslator::localLanguage(const QString &text, Engine engine) const
 {
-    if (!isSupportTranslation(engine, lang))
-        return {};
+    Language lang = scriptLanguage(text);
+    if (lang == NoLanguage && m_languageIdentifier != nullptr)
+        lang = m_languageIdentifier->identify(text);
+
+    if (lang == NoLanguage || !isSupportTranslation(engine, lang))
+        return NoLanguage;
+
+    return lang;
+}
+
+// Parse language from response language code
+QOnlineTranslator::Language QOnlineTranslator::language(Engine engine, const QString &langCode)
+{
+    // Built on first use, engine exceptions have priority over generic codes
+    static const QHash<QString, Language> googleLanguages = languageCodesIndex(s_genericLanguageCodes, s_googleLanguageCodes);
+    static const QHash<QString, Language> yandexLanguages = languageCodesIndex(s_genericLanguageCodes, s_yandexLanguageCodes);
+    static const QHash<QString, Language> bingLanguages = languageCodesIndex(s_genericLanguageCodes, s_bingLanguageCodes);
+    static const QHash<QString, Language> lingvaLanguages = languageCodesIndex(s_genericLanguageCodes, s_lingvaLanguageCodes);
 
     switch (engine) {
     case Google:
-        return s_googleLanguageCodes.value(lang, s_genericLanguageCodes.value(lang));
+        return googleLanguages.value(langCode, NoLanguage);
     case Yandex:
-        return s_yandexLanguageCodes.value(lang, s_genericLanguageCodes.value(lang));
+        return yandexLanguages.value(langCode, NoLanguage);
     case Bing:
-        return s_bingLanguageCodes.value(lang, s_genericLanguageCodes.value(lang));
+        return bingLanguages.value(langCode, NoLanguage);
     case LibreTranslate:
-        return s_genericLanguageCodes.value(lang);
+        return language(langCode);
     case Lingva:
-        return s_lingvaLanguageCodes.value(lang, s_genericLanguageCodes.value(lang));
+        return lingvaLanguages.value(langCode, NoLanguage);
     }
 
     Q_UNREACHABLE();
 }
 
-// Parse language from response language code
-QOnlineTranslator::Language QOnlineTranslator::language(Engine engine, const QString &langCode)
+// Returns the maximum number of characters per translation request
+int QOnlineTranslator::translationLimit(Engine engine)
 {
-    // Engine exceptions
     switch (engine) {
     case Google:
-        return s_googleLanguageCodes.key(langCode, s_genericLanguageCodes.key(langCode, NoLanguage));
+    case Lingva:
+        return s_googleTranslateLimit;
     case Yandex:
-        return s_yandexLanguageCodes.key(langCode, s_genericLanguageCodes.key(langCode, NoLanguage));
+        return s_yandexTranslateLimit;
     case Bing:
-        return s_bingLanguageCodes.key(langCode, s_genericLanguageCodes.key(langCode, NoLanguage));
+        return s_bingTranslateLimit;
     case LibreTranslate:
-        return s_genericLanguageCodes.key(langCode, NoLanguage);
-    case Lingva:
-        return s_lingvaLanguageCodes.key(langCode, s_genericLanguageCodes.key(langCode, NoLanguage));
+        return s_libreTranslateLimit;
     }
 
     Q_UNREACHABLE();
 }
 
-// Get split index of the text according to the limit
-int QOnlineTranslator::getSplitIndex(const QString &untranslatedText, int limit)
-{
-    if (untranslatedText.size() < limit)
-        return limit;
-
-    int splitIndex = untranslatedText.lastIndexOf(QLatin1String(". "), limit - 1);
-    if (splitIndex != -1)
-        return splitIndex + 1;
-
-    splitIndex = untranslatedText.lastIndexOf(' ', limit - 1);
-    if (splitIndex != -1)
-        return splitIndex + 1;
-
-    splitIndex = untranslatedText.lastIndexOf('\n', limit - 1);
-    if (splitIndex != -1)
-        return splitIndex + 1;
-
-    // Non-breaking space
-    splitIndex = untranslatedText.lastIndexOf(0x00a0, limit - 1);
-    if (splitIndex != -1)
-        return splitIndex + 1;
-
-    // If the text has not passed any check and is most likely garbage
-    return limit;
-}
-
 bool QOnlineTranslator::isContainsSpace(const QString &text)
 {
     return std::any_of(text.cbegin(), text.cend(), [](QChar symbol) {
@@ -23,13 +23,19 @@
 #include "qexample.h"
 #include "qoption.h"
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QPointer>
 #include <QUuid>
 #include <QVector>
 
-class QStateMachine;
-class QState;
+#include <memory>
+
+class QTimer;
+class QTranslationCache;
+class QLanguageIdentifier;
 class QNetworkAccessManager;
 class QNetworkReply;
 
@@ -42,6 +48,7 @@ class QOnlineTranslator : public QObject
     Q_DISABLE_COPY(QOnlineTranslator)
 
     friend class QOnlineTts;
+    friend class QTranslationCache;
 
 public:
     /**
@@ -203,7 +210,9 @@ public:
         /** Service unavailable or maximum number of requests */
         ServiceError,
         /** The request could not be parsed (report a bug if you see this) */
-        ParsingError
+        ParsingError,
+        /** The request or the whole translation took longer than allowed */
+        TimeoutError
     };
 
     /**
@@ -216,6 +225,13 @@ public:
      */
     explicit QOnlineTranslator(QObject *parent = nullptr);
 
+    /**
+     * @brief Destroy object
+     *
+     * If other objects wait for the same translation, they continue it.
+     */
+    ~QOnlineTranslator() override;
+
     /**
      * @brief Translate text
      *
@@ -227,9 +243,29 @@ public:
      */
     void translate(const QString &text, Engine engine = Google, Language translationLang = Auto, Language sourceLang = Auto, Language uiLang = Auto);
 
+    /**
+     * @brief Translate several texts
+     *
+     * Packs as many texts as fit into the engine limit into a single request.
+     * Texts are joined with a line break, so texts with line breaks are sent separately.
+     * Transliteration, transcription, translation options and examples are not requested.
+     * If a packed request fails, its texts are sent one by one, so each text gets its own error.
+     * Use batchTranslations() and batchErrors() to obtain results when finished() is emitted.
+     *
+     * @param texts texts to translate
+     * @param engine online engine to use
+     * @param translationLang language to translation
+     * @param sourceLang language of the passed texts
+     * @param uiLang ui language to use for display
+     */
+    void translateBatch(const QStringList &texts, Engine engine = Google, Language translationLang = Auto, Language sourceLang = Auto, Language uiLang = Auto);
+
     /**
      * @brief Detect language
      *
+     * Languages that have their own script, like Greek or Georgian, are detected locally without requests.
+     * Other languages are also detected locally if a language identifier is set, see setLanguageIdentifier().
+     *
      * @param text text for language detection
      * @param engine engine to use
      */
@@ -333,6 +369,27 @@ public:
      */
     QMap<QString, QVector<QExample>> examples() const;
 
+    /**
+     * @brief Batch translations
+     *
+     * @return translations of texts passed to the last translateBatch(), empty for texts that failed
+     */
+    QStringList batchTranslations() const;
+
+    /**
+     * @brief Batch errors
+     *
+     * @return errors for each text passed to the last translateBatch()
+     */
+    QVector<TranslationError> batchErrors() const;
+
+    /**
+     * @brief Batch error strings
+     *
+     * @return error strings for each text passed to the last translateBatch()
+     */
+    QStringList batchErrorStrings() const;
+
     /**
      * @brief Last error
      *
@@ -381,6 +438,26 @@ public:
      */
     void setTranslationTranslitEnabled(bool enable);
 
+    /**
+     * @brief Check if offline transliteration is enabled
+     *
+     * @return `true` if offline transliteration is enabled
+     * @sa QTransliterator
+     */
+    bool isOfflineTranslitEnabled() const;
+
+    /**
+     * @brief Enable or disable offline transliteration
+     *
+     * Engines that request transliteration separately from translation, like Yandex,
+     * transliterate Cyrillic, Greek, Armenian, Georgian and Hebrew scripts locally instead.
+     * Other languages are still transliterated by the engine. Disabled by default.
+     *
+     * @param enable whether to enable offline transliteration
+     * @sa QTransliterator
+     */
+    void setOfflineTranslitEnabled(bool enable);
+
     /**
      * @brief Check if source transcription is enabled
      *
@@ -448,6 +525,272 @@ public:
      */
     void setEngineApiKey(Engine engine, QByteArray apiKey);
 
+    /**
+     * @brief Network access manager
+     *
+     * If no manager was set by setNetworkAccessManager(), the object creates its own on the first call.
+     *
+     * @return network access manager that is used for requests
+     */
+    QNetworkAccessManager *networkAccessManager() const;
+
+    /**
+     * @brief Set network access manager
+     *
+     * Allows to share one manager between several objects, so they reuse
+     * its cache of DNS lookups, keep-alive connections and TLS sessions.
+     * The object does not take ownership of the manager.
+     * Should not be called while the translation is running.
+     *
+     * @param manager network access manager to use, or `nullptr` to use own manager
+     */
+    void setNetworkAccessManager(QNetworkAccessManager *manager);
+
+    /**
+     * @brief Translation cache
+     *
+     * @return cache that is used for translations or `nullptr` if no cache is used
+     */
+    QTranslationCache *cache() const;
+
+    /**
+     * @brief Set translation cache
+     *
+     * Results of translate() are looked up in the cache before sending requests.
+     * On a hit finished() is emitted on the next event loop iteration without network requests.
+     * Long texts that are split into several requests are also cached by parts,
+     * so after editing a text only the changed parts are sent again.
+     * The object does not take ownership of the cache.
+     *
+     * @param cache cache to use or `nullptr` to disable caching
+     */
+    void setCache(QTranslationCache *cache);
+
+    /**
+     * @brief Local language identifier
+     *
+     * @return identifier that is used for language detection or `nullptr` if only engines are used
+     */
+    QLanguageIdentifier *languageIdentifier() const;
+
+    /**
+     * @brief Set local language identifier
+     *
+     * Languages that the identifier recognizes with enough confidence are returned by detectLanguage()
+     * without network requests. Texts that are translated with QOnlineTranslator::Auto source language
+     * are sent with the identified language instead, if the engine supports it.
+     * The object does not take ownership of the identifier.
+     *
+     * @param identifier identifier to use or `nullptr` to detect languages only by engines
+     */
+    void setLanguageIdentifier(QLanguageIdentifier *identifier);
+
+    /**
+     * @brief Check if request coalescing is enabled
+     *
+     * @return `true` if request coalescing is enabled
+     */
+    bool isRequestCoalescingEnabled() const;
+
+    /**
+     * @brief Enable or disable request coalescing
+     *
+     * When several objects translate the same text with the same engine, languages and options at the same time,
+     * only the first one sends requests and the others receive a copy of its result, even from other threads.
+     * Aborting one of them does not affect the others. Enabled by default.
+     *
+     * @param enable whether to enable request coalescing
+     */
+    void setRequestCoalescingEnabled(bool enable);
+
+    /**
+     * @brief Maximum number of simultaneous requests
+     *
+     * @param engine engine
+     * @return maximum number of parts of a long text that are sent at once
+     */
+    int maxConcurrentRequests(Engine engine) const;
+
+    /**
+     * @brief Set maximum number of simultaneous requests
+     *
+     * Engines have a limit of characters per request, so long texts are split into several parts.
+     * By default parts are sent one by one. With a value greater than 1 up to the specified number of parts
+     * will be sent at once and their results will be combined in the original order.
+     * The first error cancels all remaining requests.
+     *
+     * @param engine engine
+     * @param count maximum number of simultaneous requests
+     */
+    void setMaxConcurrentRequests(Engine engine, int count);
+
+    /**
+     * @brief Check if hedging is enabled
+     *
+     * @return `true` if hedging is enabled
+     */
+    bool isHedgingEnabled() const;
+
+    /**
+     * @brief Enable or disable hedging
+     *
+     * If translate() does not receive a response in time, the same translation is sent to the hedge engine
+     * and the result that arrives first is used, requests of the other engine are aborted.
+     * The time is the hedge percentile of recent translation durations of the engine, see setHedgePercentile().
+     * Disabled by default.
+     *
+     * @param enable whether to enable hedging
+     */
+    void setHedgingEnabled(bool enable);
+
+    /**
+     * @brief Hedge engine
+     *
+     * @return engine that is used when the selected engine responds too slowly
+     */
+    Engine hedgeEngine() const;
+
+    /**
+     * @brief Set hedge engine
+     *
+     * Not used for translations with this engine or with languages that it does not support.
+     *
+     * @param engine engine that is used when the selected engine responds too slowly
+     */
+    void setHedgeEngine(Engine engine);
+
+    /**
+     * @brief Hedge percentile
+     *
+     * @return percentile of translation durations after which the hedge engine is used
+     */
+    qreal hedgePercentile() const;
+
+    /**
+     * @brief Set hedge percentile
+     *
+     * Durations are collected from all objects. Until enough translations are finished, one second is used.
+     *
+     * @param percentile value from 0 to 1, e.g. 0.95 sends to the hedge engine only 5% of translations
+     */
+    void setHedgePercentile(qreal percentile);
+
+    /**
+     * @brief Failover engines
+     *
+     * @return engines that are used when the selected engine fails
+     */
+    QVector<Engine> failoverEngines() const;
+
+    /**
+     * @brief Set failover engines
+     *
+     * translate() uses the selected engine and then these engines in order.
+     * An engine is skipped if it does not support the languages or its circuit is open (see isEngineAvailable()).
+     * If an engine fails with a network, service, parsing or timeout error, the translation is sent to the next one.
+     *
+     * @param engines engines to use after the selected one, empty to disable failover
+     */
+    void setFailoverEngines(const QVector<Engine> &engines);
+
+    /**
+     * @brief Request timeout
+     *
+     * @return time in milliseconds after which a request is aborted
+     */
+    int requestTimeout() const;
+
+    /**
+     * @brief Set request timeout
+     *
+     * Each part of a split text is a separate request. Timed out requests are retried,
+     * if they still fail, the translation finishes with TimeoutError.
+     *
+     * @param msec time in milliseconds after which a request is aborted, 0 to wait without limit
+     */
+    void setRequestTimeout(int msec);
+
+    /**
+     * @brief Deadline
+     *
+     * @return time in milliseconds given to a translation
+     */
+    int deadline() const;
+
+    /**
+     * @brief Set deadline
+     *
+     * Limits the whole translate(), translateBatch() or detectLanguage() call, including all parts, retries and failover engines.
+     * When the rest of the time is shorter than the time already spent, transliterations and dictionary are not requested.
+     * If only they are awaited after the deadline, the translation finishes without them.
+     * Otherwise it finishes with TimeoutError.
+     *
+     * @param msec time in milliseconds given to a translation, 0 to disable the deadline
+     */
+    void setDeadline(int msec);
+
+    /**
+     * @brief Check if an engine is available
+     *
+     * Results of requests of all objects are tracked for each engine. After several consecutive errors
+     * or with a high error rate the engine circuit opens and failover skips the engine for some time.
+     * Then a single translation is allowed as a probe, which closes the circuit on success or opens it again.
+     *
+     * @param engine engine
+     * @return `false` if the engine is known to fail
+     */
+    static bool isEngineAvailable(Engine engine);
+
+    /**
+     * @brief Statistics of a rate limit
+     */
+    struct RateLimitStats {
+        int queueSize = 0; ///< Number of requests that are waiting now
+        qint64 delayedCount = 0; ///< Number of requests that were delayed
+        qint64 totalWaitTime = 0; ///< Sum of delays in milliseconds
+        qint64 maxWaitTime = 0; ///< The longest delay in milliseconds
+    };
+
+    /**
+     * @brief Set rate limit of an engine
+     *
+     * Requests of all objects to the engine are scheduled by a token bucket:
+     * up to the burst requests can be sent at once, further requests are delayed to keep the sustained rate.
+     * Each part of a split text is a separate request.
+     *
+     * @param engine engine
+     * @param rate sustained number of requests per second, 0 to remove the limit
+     * @param burst number of requests that can be sent without delay after idle time
+     */
+    static void setRateLimit(Engine engine, qreal rate, int burst = 1);
+
+    /**
+     * @brief Set rate limit of a host
+     *
+     * Used for requests to instances of LibreTranslate and Lingva instead of the engine rate limit.
+     *
+     * @param host host of the instance URL, e.g. "libretranslate.com"
+     * @param rate sustained number of requests per second, 0 to remove the limit
+     * @param burst number of requests that can be sent without delay after idle time
+     */
+    static void setHostRateLimit(const QString &host, qreal rate, int burst = 1);
+
+    /**
+     * @brief Statistics of an engine rate limit
+     *
+     * @param engine engine
+     * @return queue and delays of the engine requests
+     */
+    static RateLimitStats rateLimitStats(Engine engine);
+
+    /**
+     * @brief Statistics of a host rate limit
+     *
+     * @param host host of the instance URL
+     * @return queue and delays of the host requests
+     */
+    static RateLimitStats hostRateLimitStats(const QString &host);
+
     /**
      * @brief Language name
      *
@@ -489,6 +832,25 @@ public:
      */
     static bool isSupportTranslation(Engine engine, Language lang);
 
+    /**
+     * @brief Check if transliteration is supported
+     *
+     * @param engine engine
+     * @param lang language
+     * @return `true` if the specified engine supports transliteration for specified language
+     */
+    static bool isSupportTranslit(Engine engine, Language lang);
+
+    /**
+     * @brief Check if dictionary is supported
+     *
+     * @param engine engine
+     * @param sourceLang source language
+     * @param translationLang translation language
+     * @return `true` if the specified engine supports translation options and examples for specified languages
+     */
+    static bool isSupportDictionary(Engine engine, Language sourceLang, Language translationLang);
+
 signals:
     /**
      * @brief Translation finished
@@ -497,96 +859,236 @@ signals:
      */
     void finished();
 
-private slots:
-    void skipGarbageText();
+private:
+    struct BatchRequest;
+    struct Pipeline;
+    struct PipelineStage;
+    struct ReplyStream;
+
+    // Parameters that affect the translation result
+    struct TranslationKey {
+        Engine engine;
+        Language sourceLang;
+        Language translationLang;
+        Language uiLang;
+        int features; // Enabled translit, transcription, options, examples and offline translit
+        QString text;
+
+        bool operator==(const TranslationKey &other) const;
+
+        friend uint qHash(const TranslationKey &key, uint seed = 0)
+        {
+            return qHash(key.text, seed) ^ (static_cast<uint>(key.engine) << 28) ^ (static_cast<uint>(key.features) << 20)
+                ^ (static_cast<uint>(key.sourceLang) << 14) ^ (static_cast<uint>(key.translationLang) << 7) ^ static_cast<uint>(key.uiLang);
+        }
+    };
+
+    // All data obtained from the engine
+    struct TranslationResult {
+        Language sourceLang = NoLanguage;
+        QString translation;
+        QString translationTranslit;
+        QString sourceTranslit;
+        QString sourceTranscription;
+        QMap<QString, QVector<QOption>> translationOptions;
+        QMap<QString, QVector<QExample>> examples;
+    };
 
-    // Google
-    void requestGoogleTranslate();
-    void parseGoogleTranslate();
+    TranslationResult result() const;
+    void setResult(const TranslationResult &result);
+    void cacheResult();
 
-    void requestYandexTranslate();
-    void parseYandexTranslate();
+    // Results of parts of split texts
+    TranslationKey segmentKey(const QString &text) const;
+    bool findSegment(const QString &text, TranslationResult &segment);
+    void appendSegment(const TranslationResult &segment);
+    void parseSegment(void (QOnlineTranslator::*parseMethod)(QNetworkReply *), QNetworkReply *reply, const QString &text);
 
-    void requestYandexSourceTranslit();
-    void parseYandexSourceTranslit();
+    // Identical translations that are running in all objects
+    struct Follower {
+        QOnlineTranslator *translator;
+        quint64 id;
+    };
+    struct Flight {
+        QOnlineTranslator *leader; // Sends requests for all followers
+        QString engineUrl; // Self-hosted instances can give different results for the same key
+        QVector<Follower> followers;
+    };
 
-    void requestYandexTranslationTranslit();
-    void parseYandexTranslationTranslit();
+    // Returns true if an identical translation is already running, otherwise registers this object as its leader
+    bool joinFlight();
+    // Detaches from the flight, the leader passes it to the first follower
+    void leaveFlight();
+    void takeOverFlight(quint64 flightId);
+    void finishFlight();
+    void finishFollowing(quint64 flightId, const TranslationResult &result, TranslationError error, const QString &errorString);
+
+    // Health of an engine, shared by all objects
+    struct CircuitBreaker {
+        enum State {
+            Closed,
+            Open, // Requests are skipped until the open duration passes
+            HalfOpen // A probe request was sent
+        };
+
+        State state = Closed;
+        int consecutiveFailures = 0;
+        QVector<bool> failures; // Results of the last requests
+        qint64 changedAt = 0; // Time when the circuit was opened or the probe was sent
+        const QOnlineTranslator *probe = nullptr; // Object that sends the probe request
+    };
 
-    void requestYandexDictionary();
-    void parseYandexDictionary();
+    // Returns position of the first engine in the chain from the position that can be used, -1 if there is none
+    int availableEnginePosition(int position) const;
+    // Restarts a failed translation with the next engine of the chain
+    bool failOver();
+    // Restarts a LibreTranslate translation that was rejected with "auto" source, now with a separate detection request
+    bool retryLibreDetection();
+    // Checks the circuit and claims the probe in one step, so only one object probes the engine
+    bool acquireEngine(Engine engine) const;
+    // Allows other objects to probe the engine if the probe of this object was stopped without result
+    void releaseEngine(Engine engine) const;
+    static void reportEngineResult(Engine engine, bool success);
+
+    // Generic cell rate algorithm, equivalent to a token bucket
+    struct RateLimit {
+        qreal interval = 0; // Milliseconds between requests at the sustained rate
+        qreal tolerance = 0; // Milliseconds by which requests can come earlier because of the burst
+        qreal arrivalTime = 0; // Theoretical time of the next request
+        RateLimitStats stats;
+    };
 
-    // Bing
-    void requestBingCredentials();
-    void parseBingCredentials();
+    static void setRateLimit(RateLimit &limit, qreal rate, int burst);
+    // Returns delay of the next request, the request is counted as sent after it
+    static qint64 reserveRequest(Engine engine, const QString &host);
+    static void finishWaiting(Engine engine, const QString &host);
+    static RateLimit *findRateLimit(Engine engine, const QString &host);
+    // Returns host of self-hosted engines, empty for the others
+    QString instanceHost(Engine engine) const;
 
-    void requestBingTranslate();
-    void parseBingTranslate();
+    // Deadline of the translation is started by the public methods and used by all its steps
+    void startDeadline();
+    void expireDeadline();
+    // Returns -1 if there is no deadline
+    int remainingTime() const;
 
-    void requestBingDictionary();
-    void parseBingDictionary();
+    void startTranslation(const QString &text, Engine engine, Language translationLang, Language sourceLang, Language uiLang);
+    // Builds and starts the pipeline for m_key
+    void startEnginePipeline();
 
-    // LibreTranslate
-    void requestLibreLangDetection();
-    void parseLibreLangDetection();
+    // Sends the translation to the hedge engine and finishes with the first result
+    void startHedge();
+    void stopHedge();
+    void finishHedge();
+    static int hedgeDelay(Engine engine, qreal percentile);
+    static void addDuration(Engine engine, qint64 duration);
+    void translateBatchGroup(const std::shared_ptr<BatchRequest> &batch);
+    void finishTranslation();
 
-    void requestLibreTranslate();
-    void parseLibreTranslate();
+    // Request functions return nullptr if there is nothing to request (e.g. the autodetected language is not supported)
+    QNetworkReply *requestGoogleTranslate(const QString &text);
 
-    // Lingva
-    void requestLingvaTranslate();
-    void parseLingvaTranslate();
+    QNetworkReply *requestYandexTranslate(const QString &text);
+    QNetworkReply *requestYandexSourceTranslit(const QString &text);
+    QNetworkReply *requestYandexTranslationTranslit(const QString &text);
+    QNetworkReply *requestYandexDictionary(const QString &text);
 
-private:
-    /*
-     * Engines have translation limit, so need to split all text into parts and make request sequentially.
-     * Also Yandex and Bing requires several requests to get dictionary, transliteration etc.
-     * We use state machine to rely async computation with signals and slots.
-     */
-    void buildGoogleStateMachine();
-    void buildGoogleDetectStateMachine();
+    QNetworkReply *requestBingCredentials(const QString &);
+    QNetworkReply *requestBingTranslate(const QString &text);
+    QNetworkReply *requestBingDictionary(const QString &text);
+
+    QNetworkReply *requestLibreLangDetection(const QString &text);
+    QNetworkReply *requestLibreTranslate(const QString &text);
+
+    QNetworkReply *requestLingvaTranslate(const QString &text);
 
-    void buildYandexStateMachine();
-    void buildYandexDetectStateMachine();
+    // Parse functions receive the reply that was returned by the corresponding request function
+    void parseGoogleTranslate(QNetworkReply *reply);
 
-    void buildBingStateMachine();
-    void buildBingDetectStateMachine();
+    void parseYandexTranslate(QNetworkReply *reply);
+    void parseYandexSourceTranslit(QNetworkReply *reply);
+    void parseYandexTranslationTranslit(QNetworkReply *reply);
+    void parseYandexDictionary(QNetworkReply *reply);
 
-    void buildLibreStateMachine();
-    void buildLibreDetectStateMachine();
+    void parseBingCredentials(QNetworkReply *reply);
+    void parseBingTranslate(QNetworkReply *reply);
+    void parseBingDictionary(QNetworkReply *reply);
 
-    void buildLingvaStateMachine();
-    void buildLingvaDetectStateMachine();
+    void parseLibreLangDetection(QNetworkReply *reply);
+    void parseLibreTranslate(QNetworkReply *reply);
 
-    // Helper functions to build nested states
-    void buildSplitNetworkRequest(QState *parent, void (QOnlineTranslator::*requestMethod)(), void (QOnlineTranslator::*parseMethod)(), const QString &text, int textLimit);
-    void buildNetworkRequestState(QState *parent, void (QOnlineTranslator::*requestMethod)(), void (QOnlineTranslator::*parseMethod)(), const QString &text = {});
+    void parseLingvaTranslate(QNetworkReply *reply);
+
+    // Read functions parse data of large replies while it is received, parse functions apply the result
+    void readGoogleTranslate(ReplyStream &stream);
+    void readLingvaTranslate(ReplyStream &stream);
+
+    /*
+     * Engines have translation limit, so need to split all text into parts and make request sequentially.
+     * Also Yandex and Bing requires several requests to get dictionary, transliteration etc.
+     * We use a pipeline of stages where each stage sends requests for parts of the text and parses replies in order.
+     */
+    void buildGooglePipeline();
+    void buildGoogleDetectPipeline();
+
+    void buildYandexPipeline();
+    void buildYandexDetectPipeline();
+
+    void buildBingPipeline();
+    void buildBingDetectPipeline();
+
+    void buildLibrePipeline();
+    void buildLibreDetectPipeline();
+
+    void buildLingvaPipeline();
+    void buildLingvaDetectPipeline();
+
+    // Helper functions to build stages
+    PipelineStage &addPipelineStage(QNetworkReply *(QOnlineTranslator::*requestMethod)(const QString &), void (QOnlineTranslator::*parseMethod)(QNetworkReply *), QString QOnlineTranslator::*text = nullptr, int textLimit = 0, int maxRequests = 1, bool cacheSegments = false);
+    void addDetectionStage(QNetworkReply *(QOnlineTranslator::*requestMethod)(const QString &), void (QOnlineTranslator::*parseMethod)(QNetworkReply *), int textLimit);
+
+    // Runs stages step by step, where a step is a stage with the following parallel stages.
+    // Each stage sends parts of its text and parses finished ones in the original order.
+    void startPipeline();
+    void startPipelineStep(const std::shared_ptr<Pipeline> &pipeline);
+    void startPipelineStage(const std::shared_ptr<Pipeline> &pipeline, int stageIndex);
+    void processPipelineStage(const std::shared_ptr<Pipeline> &pipeline, int stageIndex);
+    // Returns false if there is nothing to request for the part
+    bool sendPipelinePart(const std::shared_ptr<Pipeline> &pipeline, int stageIndex, int index);
+    // Sends the part again after a transient error, returns false if it should be parsed as failed
+    bool retryPipelinePart(const std::shared_ptr<Pipeline> &pipeline, int stageIndex, int index, QNetworkReply *reply);
+    static bool isTransientError(QNetworkReply *reply);
+    // Retries of all objects are limited to a part of sent requests, so they cannot multiply the load during outages
+    static void depositRetryBudget(Engine engine);
+    static bool withdrawRetryBudget(Engine engine);
+    void stopPipeline();
+    // Returns true if the stages that are not finished only request additional data
+    static bool hasOnlyOptionalStages(const std::shared_ptr<Pipeline> &pipeline);
+    ReplyStream takeReplyStream(QNetworkReply *reply);
+    void appendDictionary(const TranslationResult &result);
 
     // Helper functions for transliteration
-    void requestYandexTranslit(Language language);
-    void parseYandexTranslit(QString &text);
+    // Appends offline transliteration to the text and returns nullptr if it is available
+    QNetworkReply *requestYandexTranslit(Language language, const QString &text, QString &translit);
+    void parseYandexTranslit(QNetworkReply *reply, QString &text);
 
     void resetData(TranslationError error = NoError, const QString &errorString = {});
 
-    // Check for service support
-    static bool isSupportTranslit(Engine engine, Language lang);
-    static bool isSupportDictionary(Engine engine, Language sourceLang, Language translationLang);
+    // Capabilities of engines, used only at compile time to generate tables for isSupport*() functions
+    static constexpr bool hasTranslation(Engine engine, Language lang);
+    static constexpr bool hasTranslit(Engine engine, Language lang);
+    static constexpr bool hasDictionary(Engine engine, Language sourceLang, Language translationLang);
 
     // Other
-    static QString languageApiCode(Engine engine, Language lang);
+    static QLatin1String languageApiCode(Engine engine, Language lang);
     static Language language(Engine engine, const QString &langCode);
-    static int getSplitIndex(const QString &untranslatedText, int limit);
+    static Language scriptLanguage(const QString &text);
+    // Returns language that is detected without requests, NoLanguage if it is unknown or not supported by the engine
+    Language localLanguage(const QString &text, Engine engine) const;
+    static int translationLimit(Engine engine);
     static bool isContainsSpace(const QString &text);
     static void addSpaceBetweenParts(QString &text);
 
-    static const QMap<Language, QString> s_genericLanguageCodes;
-
-    // Engines have some language codes exceptions
-    static const QMap<Language, QString> s_googleLanguageCodes;
-    static const QMap<Language, QString> s_yandexLanguageCodes;
-    static const QMap<Language, QString> s_bingLanguageCodes;
-    static const QMap<Language, QString> s_lingvaLanguageCodes;
-
     // Yandex require a random UUID to be generated
     static inline QByteArray s_yandexUcid = QUuid::createUuid().toByteArray(QUuid::Id128);
 
@@ -596,20 +1098,67 @@ private:
     static inline QString s_bingIg;
     static inline QString s_bingIid;
 
-    // This properties used to store unseful information in states
-    static constexpr char s_textProperty[] = "Text";
+    // Running translations of all objects by their keys
+    static inline QMutex s_flightsMutex;
+    static inline QHash<TranslationKey, Flight> s_flights;
+    static inline quint64 s_lastFollowerId = 0;
+
+    // Circuit breakers of engines, see isEngineAvailable()
+    static constexpr int s_breakerConsecutiveFailures = 5;
+    static constexpr int s_breakerResultCount = 20;
+    static constexpr int s_breakerMinResultCount = 10;
+    static constexpr qreal s_breakerFailureRate = 0.5;
+    static constexpr qint64 s_breakerOpenDuration = 30000;
+    static inline QMutex s_breakersMutex;
+    static inline QMap<Engine, CircuitBreaker> s_breakers;
+
+    // Parts with transient errors are sent again after exponential backoff with jitter
+    static constexpr int s_maxRetries = 3;
+    static constexpr int s_retryBaseDelay = 500;
+    static constexpr int s_retryMaxDelay = 8000;
+    static constexpr qreal s_retryBudgetRatio = 0.1; // Retries that are allowed per sent request
+    static constexpr qreal s_maxRetryBudget = 10;
+    static inline QMutex s_retryBudgetsMutex;
+    static inline QMap<Engine, qreal> s_retryBudgets;
+
+    // Request schedules of engines and hosts
+    static inline QMutex s_rateLimitsMutex;
+    static inline QMap<Engine, RateLimit> s_engineRateLimits;
+    static inline QHash<QString, RateLimit> s_hostRateLimits;
+
+    // Durations of the last translations of all objects, used to calculate hedge delays
+    static constexpr int s_durationCount = 100;
+    static constexpr int s_minDurationCount = 10;
+    static constexpr int s_defaultHedgeDelay = 1000;
+    static inline QMutex s_durationsMutex;
+    static inline QMap<Engine, QVector<qint64>> s_durations;
+
+    // Texts of a batch are joined with this separator
+    static constexpr QChar s_batchSeparator = '\n';
+
+    // Distinguishes keys of split text parts from keys of whole texts
+    static constexpr int s_segmentKeyFlag = 1 << 6;
 
     // Engines have a limit of characters per translation request.
-    // If the query is larger, then it should be splited into several with getSplitIndex() helper function
+    // If the query is larger, then it should be splited into several with QTextSplitter
     static constexpr int s_googleTranslateLimit = 5000;
     static constexpr int s_yandexTranslateLimit = 150;
     static constexpr int s_yandexTranslitLimit = 180;
     static constexpr int s_bingTranslateLimit = 502;
     static constexpr int s_libreTranslateLimit = 120;
 
-    QStateMachine *m_stateMachine;
-    QNetworkAccessManager *m_networkManager;
-    QPointer<QNetworkReply> m_currentReply;
+    std::shared_ptr<Pipeline> m_pipeline; // Running translation, nullptr if there is none
+    QTimer *m_pipelineTimer; // Starts the pipeline on the next event loop iteration
+    QTimer *m_cachedFinishTimer; // Emits finished() for results that were obtained without requests, e.g. from cache
+    QTimer *m_hedgeTimer; // Starts the hedge engine when the response takes too long
+    QTimer *m_deadlineTimer; // Finishes the translation when the deadline passes
+    QOnlineTranslator *m_hedgeTranslator = nullptr; // Translates with the hedge engine, created on the first use
+    QElapsedTimer m_pipelineDuration;
+    QTranslationCache *m_cache = nullptr;
+    QLanguageIdentifier *m_languageIdentifier = nullptr;
+    TranslationKey m_key;
+    mutable QPointer<QNetworkAccessManager> m_networkManager;
+    QList<QPointer<QNetworkReply>> m_replies; // Replies that were sent after the last reset
 
     Language m_sourceLang = NoLanguage;
     Language m_translationLang = NoLanguage;
@@ -627,17 +1176,45 @@ private:
     QByteArray m_libreApiKey; // Can be empty, since free instances ignores api_key param
     QString m_libreUrl;
     QString m_lingvaUrl;
+    bool m_libreDetectionFirst = false; // The server does not support "auto" source
+    bool m_libreAutoRejected = false; // The current translation failed because of "auto" source
 
     QMap<QString, QVector<QOption>> m_translationOptions;
     QMap<QString, QVector<QExample>> m_examples;
 
     bool m_sourceTranslitEnabled = true;
     bool m_translationTranslitEnabled = true;
+    bool m_offlineTranslitEnabled = false;
+    bool m_requestCoalescingEnabled = true;
+    bool m_hedgingEnabled = false;
+    bool m_hedging = false; // Result of the hedge engine is awaited
+    Engine m_hedgeEngine = Bing;
+    qreal m_hedgePercentile = 0.95;
+
+    QVector<Engine> m_failoverEngines;
+    QVector<Engine> m_engineChain; // Selected engine and failover engines of the running translation
+    int m_enginePosition = 0;
+    bool m_aborting = false; // Errors of aborted requests do not affect engine health
+    int m_requestTimeout = 30000;
+    int m_deadline = 0;
     bool m_sourceTranscriptionEnabled = true;
     bool m_translationOptionsEnabled = true;
     bool m_examplesEnabled = true;
 
     bool m_onlyDetectLanguage = false;
+
+    // Flight of this object, see joinFlight()
+    bool m_flightLeader = false;
+    TranslationKey m_flightKey; // Key of the first engine, the translation can fail over to another one
+    quint64 m_followerId = 0; // Non-zero while waiting for the result of another object
+
+    // Maximum number of parts of a split text that can be sent at once
+    QMap<Engine, int> m_maxConcurrentRequests;
+
+    std::shared_ptr<BatchRequest> m_batch;
+    QStringList m_batchTranslations;
+    QVector<TranslationError> m_batchErrors;
+    QStringList m_batchErrorStrings;
 };
 
 #endif // QONLINETRANSLATOR_H
@@ -19,47 +19,42 @@
 
 #include "qonlinetts.h"
 
+#include "qtextsplitter.h"
+
 #include <QMetaEnum>
 #include <QUrl>
 
-const QMap<QOnlineTts::Emotion, QString> QOnlineTts::s_emotionCodes = {
-    {Neutral, QStringLiteral("neutral")},
-    {Good, QStringLiteral("good")},
-    {Evil, QStringLiteral("evil")}};
-
-const QMap<QOnlineTts::Voice, QString> QOnlineTts::s_voiceCodes = {
-    {Zahar, QStringLiteral("zahar")},
-    {Ermil, QStringLiteral("ermil")},
-    {Jane, QStringLiteral("jane")},
-    {Oksana, QStringLiteral("oksana")},
-    {Alyss, QStringLiteral("alyss")},
-    {Omazh, QStringLiteral("omazh")}};
-
-const QMap<QPair<QOnlineTranslator::Language, QLocale::Country>, QString> QOnlineTts::s_regionCodes = {
-    {{QOnlineTranslator::Bengali, QLocale::Bangladesh}, QStringLiteral("bn-BD")},
-    {{QOnlineTranslator::Bengali, QLocale::India}, QStringLiteral("bn-IN")},
-    {{QOnlineTranslator::SimplifiedChinese, QLocale::China}, QStringLiteral("cmn-Hans-CN")},
-    {{QOnlineTranslator::English, QLocale::Australia}, QStringLiteral("en-AU")},
-    {{QOnlineTranslator::English, QLocale::India}, QStringLiteral("en-IN")},
-    {{QOnlineTranslator::English, QLocale::UnitedKingdom}, QStringLiteral("en-GB")},
-    {{QOnlineTranslator::English, QLocale::UnitedStates}, QStringLiteral("en-US")},
-    {{QOnlineTranslator::French, QLocale::Canada}, QStringLiteral("fr-CA")},
-    {{QOnlineTranslator::French, QLocale::France}, QStringLiteral("fr-FR")},
-    {{QOnlineTranslator::German, QLocale::Germany}, QStringLiteral("de-DE")},
-    {{QOnlineTranslator::Portuguese, QLocale::Brazil}, QStringLiteral("pt-BR")},
-    {{QOnlineTranslator::Spanish, QLocale::Spain}, QStringLiteral("es-ES")},
-    {{QOnlineTranslator::Spanish, QLocale::UnitedStates}, QStringLiteral("es-US")},
-    {{QOnlineTranslator::Tamil, QLocale::India}, QStringLiteral("ta-IN")}};
-
-const QMap<QOnlineTranslator::Language, QList<QLocale::Country>> QOnlineTts::s_validRegions = {
-    {QOnlineTranslator::Bengali, {QLocale::Bangladesh, QLocale::India}},
-    {QOnlineTranslator::SimplifiedChinese, {QLocale::China}},
-    {QOnlineTranslator::English, {QLocale::Australia, QLocale::India, QLocale::UnitedKingdom, QLocale::UnitedStates}},
-    {QOnlineTranslator::French, {QLocale::Canada, QLocale::France}},
-    {QOnlineTranslator::German, {QLocale::Germany}},
-    {QOnlineTranslator::Portuguese, {QLocale::Brazil}},
-    {QOnlineTranslator::Spanish, {QLocale::Spain, QLocale::UnitedStates}},
-    {QOnlineTranslator::Tamil, {QLocale::India}}};
+#include <array>
+
+namespace
+{
+// Indexed by enum values
+constexpr std::array<const char *, QOnlineTts::Evil + 1> s_emotionCodes = {"neutral", "good", "evil"};
+constexpr std::array<const char *, QOnlineTts::Omazh + 1> s_voiceCodes = {"zahar", "ermil", "jane", "oksana", "alyss", "omazh"};
+
+struct RegionCode {
+    QOnlineTranslator::Language lang;
+    QLocale::Country region;
+    const char *code;
+};
+
+// Also defines valid regions for languages, regions of each language are listed together
+constexpr RegionCode s_regionCodes[] = {
+    {QOnlineTranslator::Bengali, QLocale::Bangladesh, "bn-BD"},
+    {QOnlineTranslator::Bengali, QLocale::India, "bn-IN"},
+    {QOnlineTranslator::SimplifiedChinese, QLocale::China, "cmn-Hans-CN"},
+    {QOnlineTranslator::English, QLocale::Australia, "en-AU"},
+    {QOnlineTranslator::English, QLocale::India, "en-IN"},
+    {QOnlineTranslator::English, QLocale::UnitedKingdom, "en-GB"},
+    {QOnlineTranslator::English, QLocale::UnitedStates, "en-US"},
+    {QOnlineTranslator::French, QLocale::Canada, "fr-CA"},
+    {QOnlineTranslator::French, QLocale::France, "fr-FR"},
+    {QOnlineTranslator::German, QLocale::Germany, "de-DE"},
+    {QOnlineTranslator::Portuguese, QLocale::Brazil, "pt-BR"},
+    {QOnlineTranslator::Spanish, QLocale::Spain, "es-ES"},
+    {QOnlineTranslator::Spanish, QLocale::UnitedStates, "es-US"},
+    {QOnlineTranslator::Tamil, QLocale::India, "ta-IN"}};
+}
 
 QOnlineTts::QOnlineTts(QObject *parent)
     : QObject(parent)
@@ -69,7 +64,6 @@ QOnlineTts::QOnlineTts(QObject *parent)
 void QOnlineTts::generateUrls(const QString &text, QOnlineTranslator::Engine engine, QOnlineTranslator::Language lang, Voice voice, Emotion emotion)
 {
     // Get speech
-    QString unparsedText = text;
     switch (engine) {
     case QOnlineTranslator::Google: {
         if (voice != NoVoice) {
@@ -87,17 +81,12 @@ void QOnlineTts::generateUrls(const QString &text, QOnlineTranslator::Engine eng
             return;
 
         // Google has a limit of characters per tts request. If the query is larger, then it should be splited into several
-        while (!unparsedText.isEmpty()) {
-            const int splitIndex = QOnlineTranslator::getSplitIndex(unparsedText, s_googleTtsLimit); // Split the part by special symbol
-
+        for (const QTextSplitter::Part &part : QTextSplitter::split(text, s_googleTtsLimit)) {
             // Generate URL API for add it to the playlist
             QUrl apiUrl(QStringLiteral("https://translate.googleapis.com/translate_tts"));
-            const QString query = QStringLiteral("ie=UTF-8&client=gtx&tl=%1&q=%2").arg(langString, QString(QUrl::toPercentEncoding(unparsedText.left(splitIndex))));
+            const QString query = QStringLiteral("ie=UTF-8&client=gtx&tl=%1&q=%2").arg(langString, QString(QUrl::toPercentEncoding(text.mid(part.offset, part.length))));
             apiUrl.setQuery(query);
             m_media.append(apiUrl);
-
-            // Remove the said part from the next saying
-            unparsedText = unparsedText.mid(splitIndex);
         }
         break;
     }
@@ -115,18 +104,13 @@ void QOnlineTts::generateUrls(const QString &text, QOnlineTranslator::Engine eng
             return;
 
         // Yandex has a limit of characters per tts request. If the query is larger, then it should be splited into several
-        while (!unparsedText.isEmpty()) {
-            const int splitIndex = QOnlineTranslator::getSplitIndex(unparsedText, s_yandexTtsLimit); // Split the part by special symbol
-
+        for (const QTextSplitter::Part &part : QTextSplitter::split(text, s_yandexTtsLimit)) {
             // Generate URL API for add it to the playlist
             QUrl apiUrl(QStringLiteral("https://tts.voicetech.yandex.net/tts"));
             const QString query = QStringLiteral("text=%1&lang=%2&speaker=%3&emotion=%4&format=mp3")
-                                      .arg(QUrl::toPercentEncoding(unparsedText.left(splitIndex)), langString, voiceString, emotionString);
+                                      .arg(QUrl::toPercentEncoding(text.mid(part.offset, part.length)), langString, voiceString, emotionString);
             apiUrl.setQuery(query);
             m_media.append(apiUrl);
-
-            // Remove the said part from the next saying
-            unparsedText = unparsedText.mid(splitIndex);
         }
         break;
     }
@@ -161,37 +145,70 @@ QOnlineTts::TtsError QOnlineTts::error() const
 
 QString QOnlineTts::voiceCode(Voice voice)
 {
-    return s_voiceCodes.value(voice);
+    if (voice < 0 || voice >= static_cast<int>(s_voiceCodes.size()))
+        return {};
+
+    return QLatin1String(s_voiceCodes[voice]);
 }
 
 QString QOnlineTts::regionCode(QOnlineTranslator::Language language, QLocale::Country region)
 {
-    return s_regionCodes.value({language, region}, QOnlineTranslator::languageApiCode(QOnlineTranslator::Google, language));
+    for (const RegionCode &entry : s_regionCodes) {
+        if (entry.lang == language && entry.region == region)
+            return QLatin1String(entry.code);
+    }
+
+    return QOnlineTranslator::languageApiCode(QOnlineTranslator::Google, language);
 }
 
 QString QOnlineTts::emotionCode(Emotion emotion)
 {
-    return s_emotionCodes.value(emotion);
+    if (emotion < 0 || emotion >= static_cast<int>(s_emotionCodes.size()))
+        return {};
+
+    return QLatin1String(s_emotionCodes[emotion]);
 }
 
 QOnlineTts::Emotion QOnlineTts::emotion(const QString &emotionCode)
 {
-    return s_emotionCodes.key(emotionCode, NoEmotion);
+    for (size_t i = 0; i < s_emotionCodes.size(); ++i) {
+        if (emotionCode == QLatin1String(s_emotionCodes[i]))
+            return static_cast<Emotion>(i);
+    }
+
+    return NoEmotion;
 }
 
 QOnlineTts::Voice QOnlineTts::voice(const QString &voiceCode)
 {
-    return s_voiceCodes.key(voiceCode, NoVoice);
+    for (size_t i = 0; i < s_voiceCodes.size(); ++i) {
+        if (voiceCode == QLatin1String(s_voiceCodes[i]))
+            return static_cast<Voice>(i);
+    }
+
+    return NoVoice;
 }
 
 QPair<QOnlineTranslator::Language, QLocale::Country> QOnlineTts::region(const QString &regionCode)
 {
-    return s_regionCodes.key(regionCode, {QOnlineTranslator::NoLanguage, QLocale::AnyCountry});
+    for (const RegionCode &entry : s_regionCodes) {
+        if (regionCode == QLatin1String(entry.code))
+            return {entry.lang, entry.region};
+    }
+
+    return {QOnlineTranslator::NoLanguage, QLocale::AnyCountry};
 }
 
 const QMap<QOnlineTranslator::Language, QList<QLocale::Country>> &QOnlineTts::validRegions()
 {
-    return s_validRegions;
+    // Built on first use since QMap cannot be constexpr
+    static const QMap<QOnlineTranslator::Language, QList<QLocale::Country>> regions = [] {
+        QMap<QOnlineTranslator::Language, QList<QLocale::Country>> validRegions;
+        for (const RegionCode &entry : s_regionCodes)
+            validRegions[entry.lang].append(entry.region);
+        return validRegions;
+    }();
+    return regions;
 }
 
 void QOnlineTts::setError(TtsError error, const QString &errorString)
@@ -231,11 +231,6 @@ private:
     QString voiceApiCode(QOnlineTranslator::Engine engine, Voice voice);
     QString emotionApiCode(QOnlineTranslator::Engine engine, Emotion emotion);
 
-    static const QMap<Emotion, QString> s_emotionCodes;
-    static const QMap<Voice, QString> s_voiceCodes;
-    static const QMap<QPair<QOnlineTranslator::Language, QLocale::Country>, QString> s_regionCodes;
-    static const QMap<QOnlineTranslator::Language, QList<QLocale::Country>> s_validRegions;
-
     QMap<QOnlineTranslator::Language, QLocale::Country> m_regionPreferences;
 
     static constexpr int s_googleTtsLimit = 200;
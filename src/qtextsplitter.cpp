@@ -0,0 +1,70 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "qtextsplitter.h"
+
+QVector<QTextSplitter::Part> QTextSplitter::split(const QString &text, int limit)
+{
+    QVector<Part> parts;
+    parts.reserve(text.size() / limit + 1);
+    for (int offset = 0; offset < text.size();) {
+        const int length = splitIndex(text.constData() + offset, text.size() - offset, limit);
+        parts.append({offset, length});
+        offset += length;
+    }
+    return parts;
+}
+
+int QTextSplitter::splitIndex(const QChar *text, int size, int limit)
+{
+    if (size < limit)
+        return size;
+
+    // Look for all separators in a single backward pass within the part without copying the text.
+    // Priority: ". ", space, new line, non-breaking space.
+    int spaceIndex = -1;
+    int newLineIndex = -1;
+    int nonBreakingSpaceIndex = -1;
+    for (int i = limit - 1; i >= 0; --i) {
+        const QChar symbol = text[i];
+        if (symbol == '.' && i + 1 < size && text[i + 1] == ' ')
+            return i + 1;
+
+        if (symbol == ' ') {
+            if (spaceIndex == -1)
+                spaceIndex = i;
+        } else if (symbol == '\n') {
+            if (newLineIndex == -1)
+                newLineIndex = i;
+        } else if (symbol == QChar(0x00a0)) {
+            if (nonBreakingSpaceIndex == -1)
+                nonBreakingSpaceIndex = i;
+        }
+    }
+
+    if (spaceIndex != -1)
+        return spaceIndex + 1;
+    if (newLineIndex != -1)
+        return newLineIndex + 1;
+    if (nonBreakingSpaceIndex != -1)
+        return nonBreakingSpaceIndex + 1;
+
+    // If the text has not passed any check and is most likely garbage
+    return limit;
+}
@@ -0,0 +1,65 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTEXTSPLITTER_H
+#define QTEXTSPLITTER_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Splits texts into parts that fit into request limits
+ *
+ * Parts are returned as positions in the original text, so the text is not copied until a request is built.
+ * Not a part of the public API, used by the library and its benchmarks.
+ */
+class QTextSplitter
+{
+public:
+    /**
+     * @brief Part of a text
+     */
+    struct Part {
+        int offset;
+        int length;
+    };
+
+    /**
+     * @brief Split text
+     *
+     * @param text text to split
+     * @param limit maximum length of a part
+     * @return parts that cover the whole text in order
+     */
+    static QVector<Part> split(const QString &text, int limit);
+
+    /**
+     * @brief Length of the first part
+     *
+     * Prefers to split after ". ", then after a space, a new line and a non-breaking space.
+     *
+     * @param text beginning of the text to split
+     * @param size number of characters from the beginning to the end of the text
+     * @param limit maximum length of a part
+     * @return length of the part
+     */
+    static int splitIndex(const QChar *text, int size, int limit);
+};
+
+#endif // QTEXTSPLITTER_H
@@ -0,0 +1,692 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "qtranslationcache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QVector>
+
+namespace
+{
+constexpr quint32 s_dataMagic = 0x51544344; // "QTCD"
+constexpr quint32 s_indexMagic = 0x51544349; // "QTCI"
+constexpr quint32 s_storageVersion = 1;
+constexpr quint32 s_minSlotCount = 4096;
+
+struct DataHeader {
+    quint32 magic;
+    quint32 version;
+};
+
+struct IndexHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 slotCount;
+    quint32 usedCount;
+    quint32 stale; // Index file was replaced and should be reopened
+    quint32 reserved;
+};
+
+struct IndexSlot {
+    quint64 hash; // 0 for empty slots
+    quint64 offset; // Record position in the data file
+};
+
+// Followed by the serialized key and value
+struct RecordHeader {
+    quint32 keySize;
+    quint32 valueSize;
+    quint64 hash;
+    qint64 timestamp;
+};
+
+// FNV-1a, stable between processes and Qt versions unlike qHash
+quint64 storageHash(const QByteArray &key)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (const char byte : key) {
+        hash ^= static_cast<uchar>(byte);
+        hash *= 1099511628211ULL;
+    }
+    return hash == 0 ? 1 : hash; // Zero marks empty slots
+}
+}
+
+// Append-only data file with memory-mapped open addressing index.
+// Readers do not lock the files, writers are serialized with a lock file.
+class QTranslationCache::Storage
+{
+public:
+    explicit Storage(const QString &fileName)
+        : m_dataFile(fileName)
+        , m_indexFile(fileName + QStringLiteral(".index"))
+        , m_lockFile(fileName + QStringLiteral(".lock"))
+    {
+    }
+
+    ~Storage()
+    {
+        closeFiles();
+    }
+
+    bool open()
+    {
+        if (!m_lockFile.lock())
+            return false;
+
+        const bool opened = openLocked();
+        m_lockFile.unlock();
+        return opened;
+    }
+
+    bool find(quint64 hash, const QByteArray &key, QByteArray &value, qint64 &timestamp)
+    {
+        // Index was replaced by another process
+        if (m_index == nullptr || (indexHeader()->stale != 0 && !open()))
+            return false;
+
+        const IndexSlot *indexSlots = this->indexSlots();
+        const quint32 slotCount = indexHeader()->slotCount;
+        for (quint32 i = 0; i < slotCount; ++i) {
+            const IndexSlot entry = indexSlots[(hash + i) % slotCount];
+            if (entry.hash == 0)
+                return false;
+            if (entry.hash != hash)
+                continue;
+
+            // Also protects from partially written slots
+            RecordHeader header;
+            QByteArray recordKey;
+            if (!readRecord(entry.offset, header, recordKey) || recordKey != key)
+                continue;
+
+            value = m_dataFile.read(header.valueSize);
+            timestamp = header.timestamp;
+            return value.size() == static_cast<int>(header.valueSize);
+        }
+
+        return false;
+    }
+
+    bool insert(quint64 hash, const QByteArray &key, const QByteArray &value, qint64 timestamp)
+    {
+        if (!m_lockFile.lock())
+            return false;
+
+        const bool inserted = insertLocked(hash, key, value, timestamp);
+        m_lockFile.unlock();
+        return inserted;
+    }
+
+    bool compact(qint64 timeToLive)
+    {
+        if (!m_lockFile.lock())
+            return false;
+
+        const bool compacted = (m_index != nullptr && indexHeader()->stale == 0) || openLocked() ? rewrite(true, timeToLive) : false;
+        m_lockFile.unlock();
+        return compacted;
+    }
+
+private:
+    // All functions below should be called with locked file
+    bool openLocked()
+    {
+        closeFiles();
+
+        if (!m_dataFile.open(QIODevice::ReadWrite | QIODevice::Unbuffered))
+            return false;
+
+        DataHeader header;
+        if (m_dataFile.size() < static_cast<qint64>(sizeof(DataHeader))) {
+            header = {s_dataMagic, s_storageVersion};
+            if (!m_dataFile.resize(0) || m_dataFile.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)) {
+                closeFiles();
+                return false;
+            }
+        } else if (m_dataFile.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)
+                   || header.magic != s_dataMagic
+                   || header.version != s_storageVersion) {
+            closeFiles();
+            return false;
+        }
+
+        if (mapIndex())
+            return true;
+
+        // Index is missing or corrupted, restore it from the data file
+        if (!writeIndex(scanRecords()) || !mapIndex()) {
+            closeFiles();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool mapIndex()
+    {
+        if (!m_indexFile.open(QIODevice::ReadWrite))
+            return false;
+
+        if (m_indexFile.size() >= static_cast<qint64>(sizeof(IndexHeader)))
+            m_index = m_indexFile.map(0, m_indexFile.size());
+
+        if (m_index == nullptr
+            || indexHeader()->magic != s_indexMagic
+            || indexHeader()->version != s_storageVersion
+            || indexHeader()->stale != 0
+            || m_indexFile.size() != static_cast<qint64>(sizeof(IndexHeader) + indexHeader()->slotCount * sizeof(IndexSlot))) {
+            unmapIndex();
+            return false;
+        }
+
+        return true;
+    }
+
+    void unmapIndex()
+    {
+        if (m_index != nullptr) {
+            m_indexFile.unmap(m_index);
+            m_index = nullptr;
+        }
+        m_indexFile.close();
+    }
+
+    void closeFiles()
+    {
+        unmapIndex();
+        m_dataFile.close();
+    }
+
+    bool insertLocked(quint64 hash, const QByteArray &key, const QByteArray &value, qint64 timestamp)
+    {
+        if ((m_index == nullptr || indexHeader()->stale != 0) && !openLocked())
+            return false;
+
+        // Keep probe sequences short
+        if (indexHeader()->usedCount + 1 > indexHeader()->slotCount / 10 * 7 && !rewrite(false, 0))
+            return false;
+
+        const qint64 offset = m_dataFile.size();
+        const RecordHeader header{static_cast<quint32>(key.size()), static_cast<quint32>(value.size()), hash, timestamp};
+        if (!m_dataFile.seek(offset)
+            || m_dataFile.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+            || m_dataFile.write(key) != key.size()
+            || m_dataFile.write(value) != value.size())
+            return false;
+
+        // Readers check the hash first, so the offset should be written before it
+        IndexSlot *indexSlots = this->indexSlots();
+        const quint32 slotCount = indexHeader()->slotCount;
+        for (quint32 i = 0; i < slotCount; ++i) {
+            IndexSlot &entry = indexSlots[(hash + i) % slotCount];
+            if (entry.hash == 0) {
+                entry.offset = static_cast<quint64>(offset);
+                entry.hash = hash;
+                ++indexHeader()->usedCount;
+                return true;
+            }
+
+            // Replace previous record with the same key
+            RecordHeader existingHeader;
+            QByteArray existingKey;
+            if (entry.hash == hash && readRecord(entry.offset, existingHeader, existingKey) && existingKey == key) {
+                entry.offset = static_cast<quint64>(offset);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Rewrites index with the new size and drops replaced and expired records if compactData is true
+    bool rewrite(bool compactData, qint64 timeToLive)
+    {
+        // Slots are unique by key, but different keys can have the same hash
+        QVector<IndexSlot> records;
+        records.reserve(static_cast<int>(indexHeader()->usedCount));
+        const IndexSlot *indexSlots = this->indexSlots();
+        for (quint32 i = 0; i < indexHeader()->slotCount; ++i) {
+            if (indexSlots[i].hash != 0)
+                records.append(indexSlots[i]);
+        }
+
+        if (compactData) {
+            QSaveFile newDataFile(m_dataFile.fileName());
+            if (!newDataFile.open(QIODevice::WriteOnly))
+                return false;
+
+            const DataHeader dataHeader{s_dataMagic, s_storageVersion};
+            newDataFile.write(reinterpret_cast<const char *>(&dataHeader), sizeof(dataHeader));
+
+            const qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
+            QVector<IndexSlot> compactedRecords;
+            compactedRecords.reserve(records.size());
+            for (const IndexSlot &record : qAsConst(records)) {
+                RecordHeader header;
+                QByteArray key;
+                if (!readRecord(record.offset, header, key))
+                    continue;
+                if (timeToLive > 0 && currentTime - header.timestamp > timeToLive)
+                    continue;
+
+                compactedRecords.append({record.hash, static_cast<quint64>(newDataFile.pos())});
+                newDataFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+                newDataFile.write(key);
+                newDataFile.write(m_dataFile.read(header.valueSize));
+            }
+
+            if (!newDataFile.commit())
+                return false;
+
+            records = compactedRecords;
+        }
+
+        return writeIndex(records) && openLocked();
+    }
+
+    bool writeIndex(const QVector<IndexSlot> &records)
+    {
+        quint32 slotCount = s_minSlotCount;
+        while (slotCount < static_cast<quint32>(records.size()) * 2)
+            slotCount *= 2;
+
+        QByteArray index(static_cast<int>(sizeof(IndexHeader) + slotCount * sizeof(IndexSlot)), '\0');
+        *reinterpret_cast<IndexHeader *>(index.data()) = {s_indexMagic, s_storageVersion, slotCount, static_cast<quint32>(records.size()), 0, 0};
+        auto *indexSlots = reinterpret_cast<IndexSlot *>(index.data() + sizeof(IndexHeader));
+        for (const IndexSlot &record : records) {
+            quint32 i = record.hash % slotCount;
+            while (indexSlots[i].hash != 0)
+                i = (i + 1) % slotCount;
+            indexSlots[i] = record;
+        }
+
+        QSaveFile file(m_indexFile.fileName());
+        if (!file.open(QIODevice::WriteOnly) || file.write(index) != index.size() || !file.commit())
+            return false;
+
+        // Let other processes know that they should reopen files
+        if (m_index != nullptr)
+            indexHeader()->stale = 1;
+
+        return true;
+    }
+
+    // Used only to restore the index, records are deduplicated by the full key because different keys can have the same hash
+    QVector<IndexSlot> scanRecords()
+    {
+        QHash<QByteArray, IndexSlot> records;
+        quint64 offset = sizeof(DataHeader);
+        RecordHeader header;
+        QByteArray key;
+        while (readRecord(offset, header, key)) {
+            records.insert(key, {header.hash, offset}); // Later records replace earlier ones
+            offset += sizeof(RecordHeader) + header.keySize + header.valueSize;
+        }
+
+        QVector<IndexSlot> result;
+        result.reserve(records.size());
+        for (const IndexSlot &record : qAsConst(records))
+            result.append(record);
+        return result;
+    }
+
+    // Leaves the file position at the beginning of the value
+    bool readRecord(quint64 offset, RecordHeader &header, QByteArray &key)
+    {
+        if (!m_dataFile.seek(static_cast<qint64>(offset))
+            || m_dataFile.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)
+            || offset + sizeof(header) + header.keySize + header.valueSize > static_cast<quint64>(m_dataFile.size()))
+            return false;
+
+        key = m_dataFile.read(header.keySize);
+        return key.size() == static_cast<int>(header.keySize);
+    }
+
+    IndexHeader *indexHeader() const
+    {
+        return reinterpret_cast<IndexHeader *>(m_index);
+    }
+
+    IndexSlot *indexSlots() const
+    {
+        return reinterpret_cast<IndexSlot *>(m_index + sizeof(IndexHeader));
+    }
+
+    QFile m_dataFile;
+    QFile m_indexFile;
+    QLockFile m_lockFile;
+    uchar *m_index = nullptr;
+};
+
+QTranslationCache::QTranslationCache(int maxEntries, qint64 maxBytes)
+    : m_maxEntries(maxEntries)
+    , m_maxBytes(maxBytes)
+{
+}
+
+QTranslationCache::~QTranslationCache() = default;
+
+int QTranslationCache::maxEntries() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxEntries;
+}
+
+void QTranslationCache::setMaxEntries(int maxEntries)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxEntries = maxEntries;
+    evict();
+}
+
+qint64 QTranslationCache::maxBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxBytes;
+}
+
+void QTranslationCache::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBytes = maxBytes;
+    evict();
+}
+
+int QTranslationCache::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_index.size();
+}
+
+qint64 QTranslationCache::bytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+qint64 QTranslationCache::hits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hits;
+}
+
+qint64 QTranslationCache::misses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_misses;
+}
+
+qint64 QTranslationCache::evictions() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_evictions;
+}
+
+qint64 QTranslationCache::timeToLive() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_timeToLive;
+}
+
+void QTranslationCache::setTimeToLive(qint64 seconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_timeToLive = seconds;
+}
+
+void QTranslationCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_index.clear();
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+bool QTranslationCache::open(const QString &fileName)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto storage = std::make_unique<Storage>(fileName);
+    if (!storage->open()) {
+        m_storage.reset();
+        return false;
+    }
+
+    m_storage = std::move(storage);
+    return true;
+}
+
+void QTranslationCache::close()
+{
+    QMutexLocker locker(&m_mutex);
+    m_storage.reset();
+}
+
+bool QTranslationCache::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_storage != nullptr;
+}
+
+bool QTranslationCache::compact()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_storage == nullptr)
+        return false;
+
+    return m_storage->compact(m_timeToLive * 1000);
+}
+
+bool QTranslationCache::find(const QOnlineTranslator::TranslationKey &key, QOnlineTranslator::TranslationResult &result)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        if (!isExpired(it.value()->timestamp)) {
+            // Move to the front as the most recently used
+            m_entries.splice(m_entries.begin(), m_entries, it.value());
+            result = it.value()->result;
+            ++m_hits;
+            return true;
+        }
+
+        m_bytes -= it.value()->bytes;
+        m_entries.erase(it.value());
+        m_index.erase(it);
+    }
+
+    if (m_storage != nullptr) {
+        const QByteArray storageKey = serializeKey(key);
+        QByteArray value;
+        qint64 timestamp;
+        if (m_storage->find(storageHash(storageKey), storageKey, value, timestamp) && !isExpired(timestamp)) {
+            result = deserializeResult(value);
+            insertEntry(key, result, timestamp);
+            ++m_hits;
+            return true;
+        }
+    }
+
+    ++m_misses;
+    return false;
+}
+
+void QTranslationCache::insert(const QOnlineTranslator::TranslationKey &key, const QOnlineTranslator::TranslationResult &result)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    insertEntry(key, result, timestamp);
+
+    if (m_storage != nullptr) {
+        const QByteArray storageKey = serializeKey(key);
+        m_storage->insert(storageHash(storageKey), storageKey, serializeResult(result), timestamp);
+    }
+}
+
+void QTranslationCache::insertEntry(const QOnlineTranslator::TranslationKey &key, const QOnlineTranslator::TranslationResult &result, qint64 timestamp)
+{
+    const auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_bytes -= it.value()->bytes;
+        m_entries.erase(it.value());
+        m_index.erase(it);
+    }
+
+    const qint64 bytes = entryBytes(key, result);
+    m_entries.push_front({key, result, bytes, timestamp});
+    m_index.insert(key, m_entries.begin());
+    m_bytes += bytes;
+
+    evict();
+}
+
+void QTranslationCache::evict()
+{
+    while (!m_entries.empty() && (m_index.size() > m_maxEntries || m_bytes > m_maxBytes)) {
+        const Entry &entry = m_entries.back();
+        m_bytes -= entry.bytes;
+        m_index.remove(entry.key);
+        m_entries.pop_back();
+        ++m_evictions;
+    }
+}
+
+bool QTranslationCache::isExpired(qint64 timestamp) const
+{
+    return m_timeToLive > 0 && QDateTime::currentMSecsSinceEpoch() - timestamp > m_timeToLive * 1000;
+}
+
+qint64 QTranslationCache::entryBytes(const QOnlineTranslator::TranslationKey &key, const QOnlineTranslator::TranslationResult &result)
+{
+    qint64 size = key.text.size()
+        + result.translation.size()
+        + result.translationTranslit.size()
+        + result.sourceTranslit.size()
+        + result.sourceTranscription.size();
+
+    for (auto it = result.translationOptions.cbegin(); it != result.translationOptions.cend(); ++it) {
+        size += it.key().size();
+        for (const QOption &option : it.value()) {
+            size += option.word.size() + option.gender.size();
+            for (const QString &translation : option.translations)
+                size += translation.size();
+        }
+    }
+
+    for (auto it = result.examples.cbegin(); it != result.examples.cend(); ++it) {
+        size += it.key().size();
+        for (const QExample &example : it.value())
+            size += example.example.size() + example.description.size();
+    }
+
+    return size * static_cast<qint64>(sizeof(QChar)) + static_cast<qint64>(sizeof(Entry));
+}
+
+QByteArray QTranslationCache::serializeKey(const QOnlineTranslator::TranslationKey &key)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << static_cast<qint32>(key.engine)
+           << static_cast<qint32>(key.sourceLang)
+           << static_cast<qint32>(key.translationLang)
+           << static_cast<qint32>(key.uiLang)
+           << static_cast<qint32>(key.features)
+           << key.text;
+    return data;
+}
+
+QByteArray QTranslationCache::serializeResult(const QOnlineTranslator::TranslationResult &result)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << static_cast<qint32>(result.sourceLang)
+           << result.translation
+           << result.translationTranslit
+           << result.sourceTranslit
+           << result.sourceTranscription;
+
+    stream << static_cast<qint32>(result.translationOptions.size());
+    for (auto it = result.translationOptions.cbegin(); it != result.translationOptions.cend(); ++it) {
+        stream << it.key() << static_cast<qint32>(it.value().size());
+        for (const QOption &option : it.value())
+            stream << option.word << option.gender << option.translations;
+    }
+
+    stream << static_cast<qint32>(result.examples.size());
+    for (auto it = result.examples.cbegin(); it != result.examples.cend(); ++it) {
+        stream << it.key() << static_cast<qint32>(it.value().size());
+        for (const QExample &example : it.value())
+            stream << example.example << example.description;
+    }
+
+    return data;
+}
+
+QOnlineTranslator::TranslationResult QTranslationCache::deserializeResult(const QByteArray &data)
+{
+    QOnlineTranslator::TranslationResult result;
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    qint32 sourceLang;
+    stream >> sourceLang
+        >> result.translation
+        >> result.translationTranslit
+        >> result.sourceTranslit
+        >> result.sourceTranscription;
+    result.sourceLang = static_cast<QOnlineTranslator::Language>(sourceLang);
+
+    qint32 typesCount;
+    stream >> typesCount;
+    for (qint32 i = 0; i < typesCount && stream.status() == QDataStream::Ok; ++i) {
+        QString type;
+        qint32 optionsCount;
+        stream >> type >> optionsCount;
+        QVector<QOption> &options = result.translationOptions[type];
+        for (qint32 j = 0; j < optionsCount && stream.status() == QDataStream::Ok; ++j) {
+            QOption option;
+            stream >> option.word >> option.gender >> option.translations;
+            options.append(option);
+        }
+    }
+
+    stream >> typesCount;
+    for (qint32 i = 0; i < typesCount && stream.status() == QDataStream::Ok; ++i) {
+        QString type;
+        qint32 examplesCount;
+        stream >> type >> examplesCount;
+        QVector<QExample> &examples = result.examples[type];
+        for (qint32 j = 0; j < examplesCount && stream.status() == QDataStream::Ok; ++j) {
+            QExample example;
+            stream >> example.example >> example.description;
+            examples.append(example);
+        }
+    }
+
+    return result;
+}
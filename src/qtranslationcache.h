@@ -0,0 +1,238 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTRANSLATIONCACHE_H
+#define QTRANSLATIONCACHE_H
+
+#include "qonlinetranslator.h"
+
+#include <QHash>
+#include <QMutex>
+
+#include <list>
+#include <memory>
+
+/**
+ * @brief Provides in-memory cache of translation results
+ *
+ * Stores results of QOnlineTranslator::translate() and evicts least recently used entries
+ * when the number of entries or their approximate size in bytes exceeds the limit.
+ * Can be shared between several translators and used from different threads.
+ *
+ * Example:
+ * @code
+ * QTranslationCache cache;
+ * QOnlineTranslator translator;
+ * translator.setCache(&cache);
+ *
+ * translator.translate("Hello world", QOnlineTranslator::Google); // Sends request
+ * // ...
+ * translator.translate("Hello world", QOnlineTranslator::Google); // Takes result from cache
+ * @endcode
+ *
+ * Entries can also be stored persistently with open(). The storage consists of an append-only data file
+ * and a memory-mapped hash index (the same name with `.index` suffix), so lookups do not read the whole file.
+ * Several processes on the same host can use the same storage simultaneously.
+ */
+class QTranslationCache
+{
+    Q_DISABLE_COPY(QTranslationCache)
+
+    friend class QOnlineTranslator;
+
+public:
+    /**
+     * @brief Create cache
+     *
+     * @param maxEntries maximum number of entries
+     * @param maxBytes maximum approximate size of all entries in bytes
+     */
+    explicit QTranslationCache(int maxEntries = 1000, qint64 maxBytes = 16 * 1024 * 1024);
+
+    /**
+     * @brief Destroy cache
+     *
+     * Closes persistent storage, if any.
+     */
+    ~QTranslationCache();
+
+    /**
+     * @brief Maximum number of entries
+     *
+     * @return maximum number of entries
+     */
+    int maxEntries() const;
+
+    /**
+     * @brief Set maximum number of entries
+     *
+     * Least recently used entries will be evicted if the cache contains more entries.
+     *
+     * @param maxEntries maximum number of entries
+     */
+    void setMaxEntries(int maxEntries);
+
+    /**
+     * @brief Maximum size
+     *
+     * @return maximum approximate size of all entries in bytes
+     */
+    qint64 maxBytes() const;
+
+    /**
+     * @brief Set maximum size
+     *
+     * Least recently used entries will be evicted if the size of entries exceeds the limit.
+     *
+     * @param maxBytes maximum approximate size of all entries in bytes
+     */
+    void setMaxBytes(qint64 maxBytes);
+
+    /**
+     * @brief Number of entries
+     *
+     * @return number of entries in the cache
+     */
+    int count() const;
+
+    /**
+     * @brief Size
+     *
+     * @return approximate size of all entries in bytes
+     */
+    qint64 bytes() const;
+
+    /**
+     * @brief Number of hits
+     *
+     * @return number of lookups that found an entry
+     */
+    qint64 hits() const;
+
+    /**
+     * @brief Number of misses
+     *
+     * @return number of lookups that did not find an entry
+     */
+    qint64 misses() const;
+
+    /**
+     * @brief Number of evictions
+     *
+     * @return number of entries that were removed due to the limits
+     */
+    qint64 evictions() const;
+
+    /**
+     * @brief Time to live
+     *
+     * @return time in seconds after which entries are considered expired, 0 if entries never expire
+     */
+    qint64 timeToLive() const;
+
+    /**
+     * @brief Set time to live
+     *
+     * Expired entries are ignored on lookup and removed from the persistent storage by compact().
+     *
+     * @param seconds time in seconds after which entries are considered expired, 0 to never expire
+     */
+    void setTimeToLive(qint64 seconds);
+
+    /**
+     * @brief Remove all entries
+     *
+     * Only entries in memory are removed, persistent storage is not affected.
+     * Counters are not reset.
+     */
+    void clear();
+
+    /**
+     * @brief Open persistent storage
+     *
+     * Entries that are not found in memory will be looked up in the storage
+     * and all new entries will be appended to it.
+     * Files will be created if they do not exist.
+     *
+     * @param fileName path to the data file
+     * @return `true` if the storage was successfully opened
+     */
+    bool open(const QString &fileName);
+
+    /**
+     * @brief Close persistent storage
+     */
+    void close();
+
+    /**
+     * @brief Check if persistent storage is opened
+     *
+     * @return `true` if persistent storage is opened
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Compact persistent storage
+     *
+     * Rewrites the data file without replaced and expired entries.
+     *
+     * @return `true` if the storage was successfully compacted
+     */
+    bool compact();
+
+private:
+    class Storage;
+
+    struct Entry {
+        QOnlineTranslator::TranslationKey key;
+        QOnlineTranslator::TranslationResult result;
+        qint64 bytes;
+        qint64 timestamp;
+    };
+
+    bool find(const QOnlineTranslator::TranslationKey &key, QOnlineTranslator::TranslationResult &result);
+    void insert(const QOnlineTranslator::TranslationKey &key, const QOnlineTranslator::TranslationResult &result);
+
+    // Should be called with locked mutex
+    void insertEntry(const QOnlineTranslator::TranslationKey &key, const QOnlineTranslator::TranslationResult &result, qint64 timestamp);
+    void evict();
+    bool isExpired(qint64 timestamp) const;
+
+    static qint64 entryBytes(const QOnlineTranslator::TranslationKey &key, const QOnlineTranslator::TranslationResult &result);
+    static QByteArray serializeKey(const QOnlineTranslator::TranslationKey &key);
+    static QByteArray serializeResult(const QOnlineTranslator::TranslationResult &result);
+    static QOnlineTranslator::TranslationResult deserializeResult(const QByteArray &data);
+
+    mutable QMutex m_mutex;
+    std::unique_ptr<Storage> m_storage;
+
+    std::list<Entry> m_entries; // Most recently used first
+    QHash<QOnlineTranslator::TranslationKey, std::list<Entry>::iterator> m_index;
+
+    int m_maxEntries;
+    qint64 m_maxBytes;
+    qint64 m_bytes = 0;
+    qint64 m_timeToLive = 0;
+
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+    qint64 m_evictions = 0;
+};
+
+#endif // QTRANSLATIONCACHE_H
@@ -0,0 +1,269 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "qtransliterator.h"
+
+#include <QHash>
+
+namespace
+{
+constexpr int s_maxRuleSize = 3; // Source letters in the longest rule
+
+// Letters are written as escape sequences, so the tables do not depend on the source encoding of the compiler
+struct TranslitRule {
+    const char16_t *from; // Lowercase letters
+    const char16_t *to;
+    const char16_t *initialTo = nullptr; // Replacement at the beginning of a word, if it differs
+};
+
+// Common Cyrillic letters, romanized as in Russian
+constexpr TranslitRule s_cyrillicRules[] = {
+    {u"\u0430", u"a"}, {u"\u0431", u"b"}, {u"\u0432", u"v"}, {u"\u0433", u"g"}, // а б в г
+    {u"\u0434", u"d"}, {u"\u0435", u"e"}, {u"\u0451", u"yo"}, {u"\u0436", u"zh"}, // д е ё ж
+    {u"\u0437", u"z"}, {u"\u0438", u"i"}, {u"\u0439", u"y"}, {u"\u043A", u"k"}, // з и й к
+    {u"\u043B", u"l"}, {u"\u043C", u"m"}, {u"\u043D", u"n"}, {u"\u043E", u"o"}, // л м н о
+    {u"\u043F", u"p"}, {u"\u0440", u"r"}, {u"\u0441", u"s"}, {u"\u0442", u"t"}, // п р с т
+    {u"\u0443", u"u"}, {u"\u0444", u"f"}, {u"\u0445", u"kh"}, {u"\u0446", u"ts"}, // у ф х ц
+    {u"\u0447", u"ch"}, {u"\u0448", u"sh"}, {u"\u0449", u"shch"}, {u"\u044A", u"\""}, // ч ш щ ъ
+    {u"\u044B", u"y"}, {u"\u044C", u"'"}, {u"\u044D", u"e"}, {u"\u044E", u"yu"}, // ы ь э ю
+    {u"\u044F", u"ya"}, // я
+};
+
+// Ukrainian national system
+constexpr TranslitRule s_ukrainianRules[] = {
+    {u"\u0433", u"h"}, {u"\u0491", u"g"}, {u"\u0454", u"ie", u"ye"}, {u"\u0438", u"y"}, // г ґ є и
+    {u"\u0456", u"i"}, {u"\u0457", u"i", u"yi"}, {u"\u0439", u"i", u"y"}, {u"\u044E", u"iu", u"yu"}, // і ї й ю
+    {u"\u044F", u"ia", u"ya"}, {u"\u044C", u""}, {u"\u0437\u0433", u"zgh"}, {u"\u2019", u""}, // я ь зг ’
+};
+
+constexpr TranslitRule s_belarusianRules[] = {
+    {u"\u0433", u"h"}, {u"\u0435", u"e", u"ye"}, {u"\u0456", u"i"}, {u"\u045E", u"\u016D"}, // г е і ў
+};
+
+// Bulgarian official system
+constexpr TranslitRule s_bulgarianRules[] = {
+    {u"\u0445", u"h"}, {u"\u0449", u"sht"}, {u"\u044A", u"a"}, {u"\u044C", u"y"}, // х щ ъ ь
+};
+
+// Macedonian official system
+constexpr TranslitRule s_macedonianRules[] = {
+    {u"\u0453", u"gj"}, {u"\u0455", u"dz"}, {u"\u0458", u"j"}, {u"\u0459", u"lj"}, // ѓ ѕ ј љ
+    {u"\u045A", u"nj"}, {u"\u045C", u"kj"}, {u"\u045F", u"dzh"}, {u"\u0445", u"h"}, // њ ќ џ х
+    {u"\u0446", u"c"}, // ц
+};
+
+// Serbian Latin alphabet
+constexpr TranslitRule s_serbianRules[] = {
+    {u"\u0452", u"\u0111"}, {u"\u0436", u"\u017E"}, {u"\u0458", u"j"}, {u"\u0459", u"lj"}, // ђ ж ј љ
+    {u"\u045A", u"nj"}, {u"\u045B", u"\u0107"}, {u"\u0445", u"h"}, {u"\u0446", u"c"}, // њ ћ х ц
+    {u"\u0447", u"\u010D"}, {u"\u045F", u"d\u017E"}, {u"\u0448", u"\u0161"}, // ч џ ш
+};
+
+// ELOT 743
+constexpr TranslitRule s_greekRules[] = {
+    {u"\u03B1", u"a"}, {u"\u03B2", u"v"}, {u"\u03B3", u"g"}, {u"\u03B4", u"d"}, // α β γ δ
+    {u"\u03B5", u"e"}, {u"\u03B6", u"z"}, {u"\u03B7", u"i"}, {u"\u03B8", u"th"}, // ε ζ η θ
+    {u"\u03B9", u"i"}, {u"\u03BA", u"k"}, {u"\u03BB", u"l"}, {u"\u03BC", u"m"}, // ι κ λ μ
+    {u"\u03BD", u"n"}, {u"\u03BE", u"x"}, {u"\u03BF", u"o"}, {u"\u03C0", u"p"}, // ν ξ ο π
+    {u"\u03C1", u"r"}, {u"\u03C3", u"s"}, {u"\u03C2", u"s"}, {u"\u03C4", u"t"}, // ρ σ ς τ
+    {u"\u03C5", u"y"}, {u"\u03C6", u"f"}, {u"\u03C7", u"ch"}, {u"\u03C8", u"ps"}, // υ φ χ ψ
+    {u"\u03C9", u"o"}, {u"\u03AC", u"a"}, {u"\u03AD", u"e"}, {u"\u03AE", u"i"}, // ω ά έ ή
+    {u"\u03AF", u"i"}, {u"\u03CC", u"o"}, {u"\u03CD", u"y"}, {u"\u03CE", u"o"}, // ί ό ύ ώ
+    {u"\u03CA", u"i"}, {u"\u03CB", u"y"}, {u"\u0390", u"i"}, {u"\u03B0", u"y"}, // ϊ ϋ ΐ ΰ
+    {u"\u03BF\u03C5", u"ou"}, {u"\u03BF\u03CD", u"ou"}, {u"\u03B1\u03C5", u"av"}, {u"\u03B1\u03CD", u"av"}, // ου ού αυ αύ
+    {u"\u03B5\u03C5", u"ev"}, {u"\u03B5\u03CD", u"ev"}, {u"\u03B3\u03B3", u"ng"}, {u"\u03B3\u03BE", u"nx"}, // ευ εύ γγ γξ
+    {u"\u03B3\u03C7", u"nch"}, {u"\u03BC\u03C0", u"mp", u"b"}, {u"\u03BD\u03C4", u"nt", u"d"}, // γχ μπ ντ
+};
+
+// BGN/PCGN
+constexpr TranslitRule s_armenianRules[] = {
+    {u"\u0561", u"a"}, {u"\u0562", u"b"}, {u"\u0563", u"g"}, {u"\u0564", u"d"}, // ա բ գ դ
+    {u"\u0565", u"e", u"ye"}, {u"\u0566", u"z"}, {u"\u0567", u"e"}, {u"\u0568", u"y"}, // ե զ է ը
+    {u"\u0569", u"t'"}, {u"\u056A", u"zh"}, {u"\u056B", u"i"}, {u"\u056C", u"l"}, // թ ժ ի լ
+    {u"\u056D", u"kh"}, {u"\u056E", u"ts"}, {u"\u056F", u"k"}, {u"\u0570", u"h"}, // խ ծ կ հ
+    {u"\u0571", u"dz"}, {u"\u0572", u"gh"}, {u"\u0573", u"ch"}, {u"\u0574", u"m"}, // ձ ղ ճ մ
+    {u"\u0575", u"y"}, {u"\u0576", u"n"}, {u"\u0577", u"sh"}, {u"\u0578", u"o", u"vo"}, // յ ն շ ո
+    {u"\u0579", u"ch'"}, {u"\u057A", u"p"}, {u"\u057B", u"j"}, {u"\u057C", u"r"}, // չ պ ջ ռ
+    {u"\u057D", u"s"}, {u"\u057E", u"v"}, {u"\u057F", u"t"}, {u"\u0580", u"r"}, // ս վ տ ր
+    {u"\u0581", u"ts'"}, {u"\u0582", u"w"}, {u"\u0583", u"p'"}, {u"\u0584", u"k'"}, // ց ւ փ ք
+    {u"\u0585", u"o"}, {u"\u0586", u"f"}, {u"\u0587", u"ev", u"yev"}, {u"\u0578\u0582", u"u"}, // օ ֆ և ու
+};
+
+// Georgian national system
+constexpr TranslitRule s_georgianRules[] = {
+    {u"\u10D0", u"a"}, {u"\u10D1", u"b"}, {u"\u10D2", u"g"}, {u"\u10D3", u"d"}, // ა ბ გ დ
+    {u"\u10D4", u"e"}, {u"\u10D5", u"v"}, {u"\u10D6", u"z"}, {u"\u10D7", u"t"}, // ე ვ ზ თ
+    {u"\u10D8", u"i"}, {u"\u10D9", u"k'"}, {u"\u10DA", u"l"}, {u"\u10DB", u"m"}, // ი კ ლ მ
+    {u"\u10DC", u"n"}, {u"\u10DD", u"o"}, {u"\u10DE", u"p'"}, {u"\u10DF", u"zh"}, // ნ ო პ ჟ
+    {u"\u10E0", u"r"}, {u"\u10E1", u"s"}, {u"\u10E2", u"t'"}, {u"\u10E3", u"u"}, // რ ს ტ უ
+    {u"\u10E4", u"p"}, {u"\u10E5", u"k"}, {u"\u10E6", u"gh"}, {u"\u10E7", u"q'"}, // ფ ქ ღ ყ
+    {u"\u10E8", u"sh"}, {u"\u10E9", u"ch"}, {u"\u10EA", u"ts"}, {u"\u10EB", u"dz"}, // შ ჩ ც ძ
+    {u"\u10EC", u"ts'"}, {u"\u10ED", u"ch'"}, {u"\u10EE", u"kh"}, {u"\u10EF", u"j"}, // წ ჭ ხ ჯ
+    {u"\u10F0", u"h"}, // ჰ
+};
+
+// Letters with dagesh have their own rules, vowel points are romanized when present
+constexpr TranslitRule s_hebrewRules[] = {
+    {u"\u05D0", u""}, {u"\u05D1", u"v"}, {u"\u05D1\u05BC", u"b"}, {u"\u05D2", u"g"}, // א ב בּ ג
+    {u"\u05D3", u"d"}, {u"\u05D4", u"h"}, {u"\u05D5", u"v"}, {u"\u05D5\u05B9", u"o"}, // ד ה ו וֹ
+    {u"\u05D5\u05BC", u"u"}, {u"\u05D6", u"z"}, {u"\u05D7", u"kh"}, {u"\u05D8", u"t"}, // וּ ז ח ט
+    {u"\u05D9", u"y"}, {u"\u05DB", u"kh"}, {u"\u05DA", u"kh"}, {u"\u05DB\u05BC", u"k"}, // י כ ך כּ
+    {u"\u05DC", u"l"}, {u"\u05DE", u"m"}, {u"\u05DD", u"m"}, {u"\u05E0", u"n"}, // ל מ ם נ
+    {u"\u05DF", u"n"}, {u"\u05E1", u"s"}, {u"\u05E2", u""}, {u"\u05E4", u"f"}, // ן ס ע פ
+    {u"\u05E3", u"f"}, {u"\u05E4\u05BC", u"p"}, {u"\u05E6", u"ts"}, {u"\u05E5", u"ts"}, // ף פּ צ ץ
+    {u"\u05E7", u"k"}, {u"\u05E8", u"r"}, {u"\u05E9", u"sh"}, {u"\u05E9\u05C1", u"sh"}, // ק ר ש שׁ
+    {u"\u05E9\u05C2", u"s"}, {u"\u05EA", u"t"}, // שׂ ת
+    {u"\u05B0", u""}, {u"\u05B1", u"e"}, {u"\u05B2", u"a"}, {u"\u05B3", u"o"}, // sheva, hataf segol, hataf patah, hataf qamats
+    {u"\u05B4", u"i"}, {u"\u05B5", u"e"}, {u"\u05B6", u"e"}, {u"\u05B7", u"a"}, // hiriq, tsere, segol, patah
+    {u"\u05B8", u"a"}, {u"\u05B9", u"o"}, {u"\u05BB", u"u"}, {u"\u05BC", u""}, // qamats, holam, qubuts, dagesh
+    {u"\u05BD", u""}, {u"\u05C1", u""}, {u"\u05C2", u""}, // meteg, shin dot, sin dot
+};
+
+// YIVO, with both composed letters and presentation forms
+constexpr TranslitRule s_yiddishRules[] = {
+    {u"\u05D0", u""}, {u"\u05D0\u05B7", u"a"}, {u"\uFB2E", u"a"}, {u"\u05D0\u05B8", u"o"}, // א אַ אַ אָ
+    {u"\uFB2F", u"o"}, {u"\u05D1", u"b"}, {u"\u05D1\u05BF", u"v"}, {u"\uFB4C", u"v"}, // אָ ב בֿ בֿ
+    {u"\u05D2", u"g"}, {u"\u05D3", u"d"}, {u"\u05D4", u"h"}, {u"\u05D5", u"u"}, // ג ד ה ו
+    {u"\u05D5\u05BC", u"u"}, {u"\uFB35", u"u"}, {u"\u05F0", u"v"}, {u"\u05D5\u05D5", u"v"}, // וּ וּ װ וו
+    {u"\u05F1", u"oy"}, {u"\u05D5\u05D9", u"oy"}, {u"\u05D6", u"z"}, {u"\u05D7", u"kh"}, // ױ וי ז ח
+    {u"\u05D8", u"t"}, {u"\u05D9", u"i", u"y"}, {u"\u05D9\u05B4", u"i"}, {u"\uFB1D", u"i"}, // ט י יִ יִ
+    {u"\u05F2", u"ey"}, {u"\u05D9\u05D9", u"ey"}, {u"\u05F2\u05B7", u"ay"}, {u"\uFB1F", u"ay"}, // ײ יי ײַ ײַ
+    {u"\u05D9\u05D9\u05B7", u"ay"}, {u"\u05D9\u05D9\u05B4", u"yi"}, {u"\u05DB", u"kh"}, {u"\u05DA", u"kh"}, // ייַ ייִ כ ך
+    {u"\u05DB\u05BC", u"k"}, {u"\uFB3B", u"k"}, {u"\u05DC", u"l"}, {u"\u05DE", u"m"}, // כּ כּ ל מ
+    {u"\u05DD", u"m"}, {u"\u05E0", u"n"}, {u"\u05DF", u"n"}, {u"\u05E1", u"s"}, // ם נ ן ס
+    {u"\u05E2", u"e"}, {u"\u05E4", u"f"}, {u"\u05E4\u05BC", u"p"}, {u"\uFB44", u"p"}, // ע פ פּ פּ
+    {u"\u05E4\u05BF", u"f"}, {u"\uFB4E", u"f"}, {u"\u05E3", u"f"}, {u"\u05E6", u"ts"}, // פֿ פֿ ף צ
+    {u"\u05E5", u"ts"}, {u"\u05E7", u"k"}, {u"\u05E8", u"r"}, {u"\u05E9", u"sh"}, // ץ ק ר ש
+    {u"\u05E9\u05C2", u"s"}, {u"\uFB2D", u"s"}, {u"\u05EA", u"s"}, {u"\u05EA\u05BC", u"t"}, // שׂ שּׂ ת תּ
+    {u"\uFB4A", u"t"}, {u"\u05D6\u05E9", u"zh"}, {u"\u05D8\u05E9", u"tsh"}, {u"\u05D3\u05D6\u05E9", u"dzh"}, // תּ זש טש דזש
+    {u"\u05B4", u""}, {u"\u05B7", u""}, {u"\u05B8", u""}, {u"\u05BC", u""}, // hiriq patah qamats dagesh
+    {u"\u05BF", u""}, // rafe
+};
+
+struct Replacement {
+    QString text;
+    QString initialText;
+};
+
+// Rules of a language, where keys are up to s_maxRuleSize UTF-16 code units packed into an integer
+using TranslitTable = QHash<quint64, Replacement>;
+
+quint64 ruleKey(const QChar *letters, int size)
+{
+    quint64 key = 0;
+    for (int i = 0; i < size; ++i)
+        key |= static_cast<quint64>(letters[i].unicode()) << (16 * i);
+    return key;
+}
+
+// Later rules replace earlier ones, so language rules can be added after the common rules of their script
+template<std::size_t Size>
+void addRules(TranslitTable &table, const TranslitRule (&rules)[Size])
+{
+    for (const TranslitRule &rule : rules) {
+        const QString from = QString::fromUtf16(rule.from);
+        Q_ASSERT(from.size() <= s_maxRuleSize);
+
+        const QString to = QString::fromUtf16(rule.to);
+        table.insert(ruleKey(from.constData(), from.size()), {to, rule.initialTo != nullptr ? QString::fromUtf16(rule.initialTo) : to});
+    }
+}
+
+const TranslitTable *translitTable(QOnlineTranslator::Language lang)
+{
+    static const QHash<QOnlineTranslator::Language, TranslitTable> tables = [] {
+        QHash<QOnlineTranslator::Language, TranslitTable> tables;
+        addRules(tables[QOnlineTranslator::Russian], s_cyrillicRules);
+        addRules(tables[QOnlineTranslator::Ukrainian], s_cyrillicRules);
+        addRules(tables[QOnlineTranslator::Ukrainian], s_ukrainianRules);
+        addRules(tables[QOnlineTranslator::Belarusian], s_cyrillicRules);
+        addRules(tables[QOnlineTranslator::Belarusian], s_belarusianRules);
+        addRules(tables[QOnlineTranslator::Bulgarian], s_cyrillicRules);
+        addRules(tables[QOnlineTranslator::Bulgarian], s_bulgarianRules);
+        addRules(tables[QOnlineTranslator::Macedonian], s_cyrillicRules);
+        addRules(tables[QOnlineTranslator::Macedonian], s_macedonianRules);
+        addRules(tables[QOnlineTranslator::SerbianCyrillic], s_cyrillicRules);
+        addRules(tables[QOnlineTranslator::SerbianCyrillic], s_serbianRules);
+        addRules(tables[QOnlineTranslator::Greek], s_greekRules);
+        addRules(tables[QOnlineTranslator::Armenian], s_armenianRules);
+        addRules(tables[QOnlineTranslator::Georgian], s_georgianRules);
+        addRules(tables[QOnlineTranslator::Hebrew], s_hebrewRules);
+        addRules(tables[QOnlineTranslator::Yiddish], s_yiddishRules);
+        return tables;
+    }();
+
+    const auto it = tables.constFind(lang);
+    return it != tables.cend() ? &it.value() : nullptr;
+}
+}
+
+bool QTransliterator::isSupported(QOnlineTranslator::Language lang)
+{
+    return translitTable(lang) != nullptr;
+}
+
+QString QTransliterator::transliterate(const QString &text, QOnlineTranslator::Language lang)
+{
+    const TranslitTable *table = translitTable(lang);
+    if (table == nullptr)
+        return text;
+
+    // Lowercase each code unit separately to keep positions of the original text
+    QString letters = text;
+    for (QChar &letter : letters)
+        letter = letter.toLower();
+
+    QString translit;
+    translit.reserve(text.size() * 2);
+    bool wordBegin = true;
+    for (int i = 0; i < text.size();) {
+        // The longest matching rule wins
+        TranslitTable::const_iterator rule = table->cend();
+        int ruleSize = qMin(s_maxRuleSize, text.size() - i);
+        for (; ruleSize > 0; --ruleSize) {
+            rule = table->constFind(ruleKey(letters.constData() + i, ruleSize));
+            if (rule != table->cend())
+                break;
+        }
+
+        if (ruleSize == 0) {
+            const QChar character = text.at(i);
+            translit += character;
+            wordBegin = !character.isLetterOrNumber() && !character.isMark();
+            ++i;
+            continue;
+        }
+
+        QString replacement = wordBegin ? rule->initialText : rule->text;
+        if (text.at(i).isUpper() && !replacement.isEmpty()) {
+            // Words in capitals stay in capitals, otherwise only the first letter is capitalized
+            const bool capitals = (i + ruleSize < text.size() && text.at(i + ruleSize).isUpper()) || (i != 0 && text.at(i - 1).isUpper());
+            if (capitals)
+                replacement = replacement.toUpper();
+            else
+                replacement[0] = replacement.at(0).toUpper();
+        }
+
+        translit += replacement;
+        wordBegin = false;
+        i += ruleSize;
+    }
+
+    return translit;
+}
@@ -0,0 +1,61 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTRANSLITERATOR_H
+#define QTRANSLITERATOR_H
+
+#include "qonlinetranslator.h"
+
+/**
+ * @brief Provides transliteration to Latin script by rule tables
+ *
+ * Covers alphabetic scripts that can be transliterated letter by letter:
+ * Cyrillic, Greek, Armenian, Georgian and Hebrew. Each language has its own table,
+ * where a rule replaces one or several letters and can have a separate form for the beginning of a word.
+ * Letter case of the source text is preserved.
+ *
+ * Used by QOnlineTranslator instead of transliteration requests when offline transliteration is enabled.
+ *
+ * Example:
+ * @code
+ * QTransliterator::transliterate("Щи да каша", QOnlineTranslator::Russian); // "Shchi da kasha"
+ * @endcode
+ */
+class QTransliterator
+{
+public:
+    /**
+     * @brief Check if a language is supported
+     *
+     * @param lang language
+     * @return `true` if the language has a rule table
+     */
+    static bool isSupported(QOnlineTranslator::Language lang);
+
+    /**
+     * @brief Transliterate text
+     *
+     * @param text text to transliterate
+     * @param lang language of the text
+     * @return text in Latin script, characters without rules are left unchanged
+     */
+    static QString transliterate(const QString &text, QOnlineTranslator::Language lang);
+};
+
+#endif // QTRANSLITERATOR_H
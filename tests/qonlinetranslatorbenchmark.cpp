@@ -0,0 +1,404 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "qexample.h"
+#include "qgooglereplyreader.h"
+#include "qonlinetranslator.h"
+#include "qoption.h"
+#include "qtextsplitter.h"
+
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSslKey>
+#include <QSslSocket>
+#include <QTcpServer>
+#include <QTest>
+
+#include <utility>
+
+namespace
+{
+// Local HTTPS server that stands in for LibreTranslate, keeps connections alive and counts TLS handshakes
+class StandInServer : public QTcpServer
+{
+public:
+    StandInServer(const QSslCertificate &certificate, const QSslKey &key)
+        : m_certificate(certificate)
+        , m_key(key)
+    {
+    }
+
+    int handshakes() const
+    {
+        return m_handshakes;
+    }
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        auto *socket = new QSslSocket(this);
+        if (!socket->setSocketDescriptor(socketDescriptor)) {
+            delete socket;
+            return;
+        }
+
+        socket->setLocalCertificate(m_certificate);
+        socket->setPrivateKey(m_key);
+        connect(socket, &QSslSocket::encrypted, this, [this] {
+            ++m_handshakes;
+        });
+        connect(socket, &QSslSocket::readyRead, this, [this, socket] {
+            answer(socket);
+        });
+        connect(socket, &QSslSocket::disconnected, this, [this, socket] {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+        socket->startServerEncryption();
+    }
+
+private:
+    // Answers all complete requests in the buffer of the socket
+    void answer(QSslSocket *socket)
+    {
+        QByteArray &buffer = m_buffers[socket];
+        buffer += socket->readAll();
+
+        forever {
+            const int headerEnd = buffer.indexOf("\r\n\r\n");
+            if (headerEnd == -1)
+                return;
+
+            int contentLength = 0;
+            for (const QByteArray &line : buffer.left(headerEnd).split('\n')) {
+                if (line.toLower().startsWith("content-length:"))
+                    contentLength = line.mid(15).trimmed().toInt();
+            }
+
+            const int requestSize = headerEnd + 4 + contentLength;
+            if (buffer.size() < requestSize)
+                return;
+
+            buffer.remove(0, requestSize);
+            socket->write("HTTP/1.1 200 OK\r\n"
+                          "Content-Type: application/json\r\n"
+                          "Content-Length: 26\r\n"
+                          "Connection: keep-alive\r\n"
+                          "\r\n"
+                          "{\"translatedText\":\"Hallo\"}");
+        }
+    }
+
+    QSslCertificate m_certificate;
+    QSslKey m_key;
+    QHash<QSslSocket *, QByteArray> m_buffers;
+    int m_handshakes = 0;
+};
+
+struct GoogleDocument {
+    QString translation;
+    QString translationTranslit;
+    QString sourceTranslit;
+    QMap<QString, QVector<QOption>> options;
+    QMap<QString, QVector<QExample>> examples;
+};
+
+// Parsing with QJsonDocument that was used before the stream reader
+GoogleDocument parseGoogleDocument(const QByteArray &data)
+{
+    GoogleDocument result;
+    const QJsonArray jsonData = QJsonDocument::fromJson(data).array();
+
+    for (const QJsonValueRef translationData : jsonData.at(0).toArray()) {
+        const QJsonArray translationArray = translationData.toArray();
+        result.translation.append(translationArray.at(0).toString());
+        if (translationArray.size() > 2) {
+            result.translationTranslit.append(translationArray.at(2).toString());
+            result.sourceTranslit.append(translationArray.at(3).toString());
+        }
+    }
+
+    for (const QJsonValueRef typeOfSpeechData : jsonData.at(1).toArray()) {
+        const QJsonArray typeOfSpeechDataArray = typeOfSpeechData.toArray();
+        const QString typeOfSpeech = typeOfSpeechDataArray.at(0).toString();
+        for (const QJsonValueRef wordData : typeOfSpeechDataArray.at(2).toArray()) {
+            const QJsonArray wordDataArray = wordData.toArray();
+            const QString word = wordDataArray.at(0).toString();
+            const QString gender = wordDataArray.at(4).toString();
+            const QJsonArray translationsArray = wordDataArray.at(1).toArray();
+            QStringList translations;
+            translations.reserve(translationsArray.size());
+            for (const QJsonValue &wordTranslation : translationsArray)
+                translations.append(wordTranslation.toString());
+            result.options[typeOfSpeech].append({word, gender, translations});
+        }
+    }
+
+    for (const QJsonValueRef exampleData : jsonData.at(12).toArray()) {
+        const QJsonArray exampleDataArray = exampleData.toArray();
+        const QString typeOfSpeech = exampleDataArray.at(0).toString();
+        for (const QJsonValueRef example : exampleDataArray.at(1).toArray()) {
+            const QJsonArray exampleArray = example.toArray();
+            result.examples[typeOfSpeech].append({exampleArray.at(2).toString(), exampleArray.at(0).toString()});
+        }
+    }
+
+    return result;
+}
+}
+
+class QOnlineTranslatorBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void splitText_data();
+    void splitText();
+    void languageLookup_data();
+    void languageLookup();
+    void googleReply_data();
+    void googleReply();
+    void sharedNetworkManager_data();
+    void sharedNetworkManager();
+};
+
+void QOnlineTranslatorBenchmark::splitText_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("copyParts");
+
+    const std::pair<const char *, int> sizes[] = {
+        {"1 KB", 1024},
+        {"10 KB", 10 * 1024},
+        {"100 KB", 100 * 1024},
+        {"1 MB", 1024 * 1024},
+        {"10 MB", 10 * 1024 * 1024},
+        {"50 MB", 50 * 1024 * 1024},
+    };
+    for (const auto &[name, size] : sizes) {
+        QTest::newRow((QByteArray(name) + ", positions").constData()) << size << false;
+        QTest::newRow((QByteArray(name) + ", copies").constData()) << size << true;
+    }
+}
+
+// Time should grow linearly with the size, each row is 10 times larger than the previous one except the last.
+// Rows with copies split the text into strings as it was done before the parts were stored as positions.
+void QOnlineTranslatorBenchmark::splitText()
+{
+    QFETCH(int, size);
+    QFETCH(bool, copyParts);
+
+    // Contains all separators that the splitter looks for
+    const QString sentence = QStringLiteral("Lorem ipsum dolor sit amet, consectetur adipiscing elit. Sed do\neiusmod tempor\u00A0incididunt ut labore ");
+    QString text;
+    text.reserve(size + sentence.size());
+    while (text.size() < size)
+        text += sentence;
+    text.truncate(size);
+
+    // The smallest limit, used for Yandex, gives the most parts
+    const int limit = 150;
+    int parts = 0;
+    if (copyParts) {
+        QBENCHMARK {
+            QStringList textParts;
+            for (int offset = 0; offset < text.size();) {
+                const int length = QTextSplitter::splitIndex(text.constData() + offset, text.size() - offset, limit);
+                textParts.append(text.mid(offset, length));
+                offset += length;
+            }
+            parts = textParts.size();
+        }
+    } else {
+        QBENCHMARK {
+            parts = QTextSplitter::split(text, limit).size();
+        }
+    }
+
+    QVERIFY(parts >= size / limit);
+}
+
+void QOnlineTranslatorBenchmark::languageLookup_data()
+{
+    QTest::addColumn<bool>("linearScan");
+
+    QTest::newRow("index") << false;
+    QTest::newRow("QMap::key()") << true;
+}
+
+// Each iteration looks up all codes, so the result divided by their number is the cost of a single lookup.
+// Codes of engines are looked up by the same kind of index, only with engine-specific exceptions.
+void QOnlineTranslatorBenchmark::languageLookup()
+{
+    QFETCH(bool, linearScan);
+
+    QMap<QOnlineTranslator::Language, QString> codes;
+    for (int i = QOnlineTranslator::Auto; i <= QOnlineTranslator::Zulu; ++i) {
+        const auto lang = static_cast<QOnlineTranslator::Language>(i);
+        codes.insert(lang, QOnlineTranslator::languageCode(lang));
+    }
+    const QStringList lookedUpCodes = codes.values();
+
+    // Build the index before measuring
+    QOnlineTranslator::Language lang = QOnlineTranslator::language(lookedUpCodes.first());
+
+    if (linearScan) {
+        // Reverse lookup that was used before the indexes
+        QBENCHMARK {
+            for (const QString &code : lookedUpCodes)
+                lang = codes.key(code, QOnlineTranslator::NoLanguage);
+        }
+    } else {
+        QBENCHMARK {
+            for (const QString &code : lookedUpCodes)
+                lang = QOnlineTranslator::language(code);
+        }
+    }
+
+    QVERIFY(lang != QOnlineTranslator::NoLanguage);
+}
+
+void QOnlineTranslatorBenchmark::googleReply_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<int>("chunkSize");
+    QTest::addColumn<bool>("jsonDocument");
+
+    const std::pair<const char *, const char *> files[] = {
+        {"1 KB", "google-1kb.json"},
+        {"5 KB", "google-5kb.json"},
+        {"50 KB", "google-50kb.json"},
+    };
+    for (const auto &[name, fileName] : files) {
+        QTest::newRow((QByteArray(name) + ", reader").constData()) << QString(fileName) << 0 << false;
+        QTest::newRow((QByteArray(name) + ", reader in 1 KB chunks").constData()) << QString(fileName) << 1024 << false;
+        QTest::newRow((QByteArray(name) + ", QJsonDocument").constData()) << QString(fileName) << 0 << true;
+    }
+}
+
+// Both parsers read the same recorded bytes, chunked rows include the cost of resuming between network packets
+void QOnlineTranslatorBenchmark::googleReply()
+{
+    QFETCH(QString, fileName);
+    QFETCH(int, chunkSize);
+    QFETCH(bool, jsonDocument);
+
+    QFile file(QFINDTESTDATA("data/" + fileName));
+    QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(file.errorString()));
+    const QByteArray data = file.readAll();
+
+    // Used as a reference for the reader
+    const GoogleDocument document = parseGoogleDocument(data);
+    QVERIFY(!document.translation.isEmpty());
+
+    if (jsonDocument) {
+        GoogleDocument result;
+        QBENCHMARK {
+            result = parseGoogleDocument(data);
+        }
+        QCOMPARE(result.translation, document.translation);
+        return;
+    }
+
+    // Reply is received at once without chunk size
+    if (chunkSize == 0)
+        chunkSize = data.size();
+    QVector<QByteArray> chunks;
+    for (int i = 0; i < data.size(); i += chunkSize)
+        chunks.append(data.mid(i, chunkSize));
+
+    QGoogleReplyReader reader;
+    QBENCHMARK {
+        reader = QGoogleReplyReader();
+        reader.setTranslationTranslitEnabled(true);
+        reader.setSourceTranslitEnabled(true);
+        reader.setTranslationOptionsEnabled(true);
+        reader.setExamplesEnabled(true);
+        for (const QByteArray &chunk : qAsConst(chunks))
+            reader.addData(chunk);
+    }
+
+    QVERIFY(reader.atEnd());
+    QCOMPARE(reader.translation(), document.translation);
+    QCOMPARE(reader.translationTranslit(), document.translationTranslit);
+    QCOMPARE(reader.sourceTranslit(), document.sourceTranslit);
+    QCOMPARE(reader.translationOptions().keys(), document.options.keys());
+    QCOMPARE(reader.examples().keys(), document.examples.keys());
+}
+
+void QOnlineTranslatorBenchmark::sharedNetworkManager_data()
+{
+    QTest::addColumn<bool>("shared");
+
+    QTest::newRow("own managers") << false;
+    QTest::newRow("shared manager") << true;
+}
+
+// Reports TLS handshakes for 1000 translations by short-lived objects, the difference between rows is the number of saved handshakes
+void QOnlineTranslatorBenchmark::sharedNetworkManager()
+{
+    QFETCH(bool, shared);
+
+    if (!QSslSocket::supportsSsl())
+        QSKIP("SSL is not supported");
+
+    QFile certificateFile(QFINDTESTDATA("data/localhost.crt"));
+    QFile keyFile(QFINDTESTDATA("data/localhost.key"));
+    QVERIFY2(certificateFile.open(QIODevice::ReadOnly), qPrintable(certificateFile.errorString()));
+    QVERIFY2(keyFile.open(QIODevice::ReadOnly), qPrintable(keyFile.errorString()));
+
+    StandInServer server(QSslCertificate(&certificateFile), QSslKey(&keyFile, QSsl::Rsa));
+    QVERIFY2(server.listen(QHostAddress::LocalHost), qPrintable(server.errorString()));
+    const QString url = QStringLiteral("https://127.0.0.1:%1").arg(server.serverPort());
+
+    // The certificate is self-signed
+    const auto ignoreSslErrors = [](QNetworkReply *reply) {
+        reply->ignoreSslErrors();
+    };
+    QNetworkAccessManager sharedManager;
+    connect(&sharedManager, &QNetworkAccessManager::sslErrors, ignoreSslErrors);
+
+    for (int i = 0; i < 1000; ++i) {
+        QOnlineTranslator translator;
+        translator.setEngineUrl(QOnlineTranslator::LibreTranslate, url);
+        if (shared)
+            translator.setNetworkAccessManager(&sharedManager);
+        else
+            connect(translator.networkAccessManager(), &QNetworkAccessManager::sslErrors, ignoreSslErrors);
+
+        QEventLoop loop;
+        connect(&translator, &QOnlineTranslator::finished, &loop, &QEventLoop::quit);
+        translator.translate(QStringLiteral("Hello"), QOnlineTranslator::LibreTranslate, QOnlineTranslator::German, QOnlineTranslator::English, QOnlineTranslator::English);
+        loop.exec();
+
+        QVERIFY2(translator.error() == QOnlineTranslator::NoError, qPrintable(translator.errorString()));
+        QCOMPARE(translator.translation(), QStringLiteral("Hallo"));
+    }
+
+    QTest::setBenchmarkResult(server.handshakes(), QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(QOnlineTranslatorBenchmark)
+
+#include "qonlinetranslatorbenchmark.moc"
@@ -0,0 +1,369 @@
+/*
+ *  Copyright © 2018-2023 Hennadii Chernyshchyk <genaloner@gmail.com>
+ *
+ *  This file is part of QOnlineTranslator.
+ *
+ *  QOnlineTranslator is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  QOnlineTranslator is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with QOnlineTranslator. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "qenginecapabilities.h"
+#include "qonlinetranslator.h"
+
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaEnum>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTest>
+#include <QTimer>
+#include <QUrlQuery>
+
+#include <cstring>
+#include <functional>
+
+namespace
+{
+// Answers with the given data on the next event loop iteration
+class FixtureReply : public QNetworkReply
+{
+public:
+    FixtureReply(QNetworkAccessManager::Operation operation, const QNetworkRequest &request, const QByteArray &data, int status, QObject *parent)
+        : QNetworkReply(parent)
+        , m_data(data)
+    {
+        setRequest(request);
+        setUrl(request.url());
+        setOperation(operation);
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, status);
+        if (status >= 400)
+            setError(status == 400 ? QNetworkReply::ProtocolInvalidOperationError : QNetworkReply::UnknownContentError, QStringLiteral("HTTP status %1").arg(status));
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+        QTimer::singleShot(0, this, [this] {
+            emit metaDataChanged();
+            emit readyRead();
+            setFinished(true);
+            emit finished();
+        });
+    }
+
+    void abort() override
+    {
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        return m_data.size() - m_position + QNetworkReply::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        const qint64 size = qMin<qint64>(maxSize, m_data.size() - m_position);
+        std::memcpy(data, m_data.constData() + m_position, static_cast<size_t>(size));
+        m_position += size;
+        return size;
+    }
+
+private:
+    QByteArray m_data;
+    qint64 m_position = 0;
+};
+
+// Replies to requests with data from the handler without network
+class FixtureNetworkManager : public QNetworkAccessManager
+{
+public:
+    using Handler = std::function<QByteArray(const QNetworkRequest &request, const QByteArray &body, int &status)>;
+
+    explicit FixtureNetworkManager(Handler handler)
+        : m_handler(std::move(handler))
+    {
+    }
+
+protected:
+    QNetworkReply *createRequest(Operation operation, const QNetworkRequest &request, QIODevice *outgoingData) override
+    {
+        const QByteArray body = outgoingData != nullptr ? outgoingData->readAll() : QByteArray();
+        int status = 200;
+        const QByteArray data = m_handler(request, body, status);
+        return new FixtureReply(operation, request, data, status, this);
+    }
+
+private:
+    Handler m_handler;
+};
+}
+
+class QOnlineTranslatorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void translationSupport_data();
+    void translationSupport();
+    void translitSupport_data();
+    void translitSupport();
+    void dictionarySupport_data();
+    void dictionarySupport();
+    void batchTranslation_data();
+    void batchTranslation();
+    void libreDetectionFallback();
+    void googleReplyErrors_data();
+    void googleReplyErrors();
+
+private:
+    static QTestData &addSupportRow(QOnlineTranslator::Engine engine, QOnlineTranslator::Language lang);
+    static QByteArray name(QOnlineTranslator::Engine engine);
+    static QByteArray name(QOnlineTranslator::Language lang);
+};
+
+// Generated tables are checked against pairs that were taken from the switch statements the tables replaced
+
+void QOnlineTranslatorTest::translationSupport_data()
+{
+    QTest::addColumn<QOnlineTranslator::Engine>("engine");
+    QTest::addColumn<QOnlineTranslator::Language>("lang");
+    QTest::addColumn<bool>("supported");
+
+    addSupportRow(QOnlineTranslator::Google, QOnlineTranslator::English) << true;
+    addSupportRow(QOnlineTranslator::Google, QOnlineTranslator::Auto) << true;
+    addSupportRow(QOnlineTranslator::Google, QOnlineTranslator::Bashkir) << false;
+    addSupportRow(QOnlineTranslator::Google, QOnlineTranslator::Georgian) << false;
+    addSupportRow(QOnlineTranslator::Google, QOnlineTranslator::NoLanguage) << false;
+    addSupportRow(QOnlineTranslator::Yandex, QOnlineTranslator::Russian) << true;
+    addSupportRow(QOnlineTranslator::Yandex, QOnlineTranslator::Bashkir) << true;
+    addSupportRow(QOnlineTranslator::Yandex, QOnlineTranslator::Cantonese) << false;
+    addSupportRow(QOnlineTranslator::Yandex, QOnlineTranslator::Zulu) << false;
+    addSupportRow(QOnlineTranslator::Bing, QOnlineTranslator::German) << true;
+    addSupportRow(QOnlineTranslator::Bing, QOnlineTranslator::Klingon) << true;
+    addSupportRow(QOnlineTranslator::Bing, QOnlineTranslator::Albanian) << false;
+    addSupportRow(QOnlineTranslator::LibreTranslate, QOnlineTranslator::English) << true;
+    addSupportRow(QOnlineTranslator::LibreTranslate, QOnlineTranslator::Afrikaans) << false;
+    addSupportRow(QOnlineTranslator::Lingva, QOnlineTranslator::Japanese) << true;
+    addSupportRow(QOnlineTranslator::Lingva, QOnlineTranslator::Filipino) << false;
+}
+
+void QOnlineTranslatorTest::translationSupport()
+{
+    QFETCH(QOnlineTranslator::Engine, engine);
+    QFETCH(QOnlineTranslator::Language, lang);
+    QFETCH(bool, supported);
+
+    QCOMPARE(QOnlineTranslator::isSupportTranslation(engine, lang), supported);
+}
+
+void QOnlineTranslatorTest::translitSupport_data()
+{
+    QTest::addColumn<QOnlineTranslator::Engine>("engine");
+    QTest::addColumn<QOnlineTranslator::Language>("lang");
+    QTest::addColumn<bool>("supported");
+
+    // Google supports transliteration for all languages that it translates
+    addSupportRow(QOnlineTranslator::Google, QOnlineTranslator::Japanese) << true;
+    addSupportRow(QOnlineTranslator::Google, QOnlineTranslator::Klingon) << false;
+    addSupportRow(QOnlineTranslator::Lingva, QOnlineTranslator::Russian) << true;
+    addSupportRow(QOnlineTranslator::Lingva, QOnlineTranslator::Fijian) << false;
+    addSupportRow(QOnlineTranslator::Yandex, QOnlineTranslator::Russian) << true;
+    addSupportRow(QOnlineTranslator::Yandex, QOnlineTranslator::German) << false;
+    addSupportRow(QOnlineTranslator::Bing, QOnlineTranslator::SerbianLatin) << true;
+    addSupportRow(QOnlineTranslator::Bing, QOnlineTranslator::Russian) << false;
+    addSupportRow(QOnlineTranslator::LibreTranslate, QOnlineTranslator::Japanese) << false;
+}
+
+void QOnlineTranslatorTest::translitSupport()
+{
+    QFETCH(QOnlineTranslator::Engine, engine);
+    QFETCH(QOnlineTranslator::Language, lang);
+    QFETCH(bool, supported);
+
+    QCOMPARE(QOnlineTranslator::isSupportTranslit(engine, lang), supported);
+}
+
+void QOnlineTranslatorTest::dictionarySupport_data()
+{
+    QTest::addColumn<QOnlineTranslator::Engine>("engine");
+    QTest::addColumn<QOnlineTranslator::Language>("sourceLang");
+    QTest::addColumn<QOnlineTranslator::Language>("translationLang");
+    QTest::addColumn<bool>("supported");
+
+    QTest::newRow((name(QOnlineTranslator::Google) + ' ' + name(QOnlineTranslator::English) + " -> " + name(QOnlineTranslator::German)).constData()) << QOnlineTranslator::Google << QOnlineTranslator::English << QOnlineTranslator::German << true;
+    QTest::newRow((name(QOnlineTranslator::Google) + ' ' + name(QOnlineTranslator::English) + " -> " + name(QOnlineTranslator::Georgian)).constData()) << QOnlineTranslator::Google << QOnlineTranslator::English << QOnlineTranslator::Georgian << false;
+    QTest::newRow((name(QOnlineTranslator::Yandex) + ' ' + name(QOnlineTranslator::German) + " -> " + name(QOnlineTranslator::Turkish)).constData()) << QOnlineTranslator::Yandex << QOnlineTranslator::German << QOnlineTranslator::Turkish << true;
+    QTest::newRow((name(QOnlineTranslator::Yandex) + ' ' + name(QOnlineTranslator::Belarusian) + " -> " + name(QOnlineTranslator::Belarusian)).constData()) << QOnlineTranslator::Yandex << QOnlineTranslator::Belarusian << QOnlineTranslator::Belarusian << true;
+    QTest::newRow((name(QOnlineTranslator::Yandex) + ' ' + name(QOnlineTranslator::Bulgarian) + " -> " + name(QOnlineTranslator::English)).constData()) << QOnlineTranslator::Yandex << QOnlineTranslator::Bulgarian << QOnlineTranslator::English << false;
+    QTest::newRow((name(QOnlineTranslator::Bing) + ' ' + name(QOnlineTranslator::English) + " -> " + name(QOnlineTranslator::Welsh)).constData()) << QOnlineTranslator::Bing << QOnlineTranslator::English << QOnlineTranslator::Welsh << true;
+    QTest::newRow((name(QOnlineTranslator::Bing) + ' ' + name(QOnlineTranslator::Welsh) + " -> " + name(QOnlineTranslator::English)).constData()) << QOnlineTranslator::Bing << QOnlineTranslator::Welsh << QOnlineTranslator::English << true;
+    QTest::newRow((name(QOnlineTranslator::Bing) + ' ' + name(QOnlineTranslator::German) + " -> " + name(QOnlineTranslator::French)).constData()) << QOnlineTranslator::Bing << QOnlineTranslator::German << QOnlineTranslator::French << false;
+    QTest::newRow((name(QOnlineTranslator::Bing) + ' ' + name(QOnlineTranslator::English) + " -> " + name(QOnlineTranslator::Albanian)).constData()) << QOnlineTranslator::Bing << QOnlineTranslator::English << QOnlineTranslator::Albanian << false;
+    QTest::newRow((name(QOnlineTranslator::LibreTranslate) + ' ' + name(QOnlineTranslator::English) + " -> " + name(QOnlineTranslator::German)).constData()) << QOnlineTranslator::LibreTranslate << QOnlineTranslator::English << QOnlineTranslator::German << false;
+    QTest::newRow((name(QOnlineTranslator::Lingva) + ' ' + name(QOnlineTranslator::English) + " -> " + name(QOnlineTranslator::German)).constData()) << QOnlineTranslator::Lingva << QOnlineTranslator::English << QOnlineTranslator::German << false;
+}
+
+void QOnlineTranslatorTest::dictionarySupport()
+{
+    QFETCH(QOnlineTranslator::Engine, engine);
+    QFETCH(QOnlineTranslator::Language, sourceLang);
+    QFETCH(QOnlineTranslator::Language, translationLang);
+    QFETCH(bool, supported);
+
+    QCOMPARE(QOnlineTranslator::isSupportDictionary(engine, sourceLang, translationLang), supported);
+}
+
+void QOnlineTranslatorTest::batchTranslation_data()
+{
+    QTest::addColumn<QStringList>("texts");
+    QTest::addColumn<bool>("mergeLines");
+    QTest::addColumn<QStringList>("translations");
+    QTest::addColumn<int>("requests");
+
+    const QStringList texts = {QStringLiteral("one"), QStringLiteral("two"), QStringLiteral("three")};
+    const QStringList translations = {QStringLiteral("ONE"), QStringLiteral("TWO"), QStringLiteral("THREE")};
+    QTest::newRow("packed") << texts << false << translations << 1;
+    QTest::newRow("lines mismatch") << texts << true << translations << 4;
+    QTest::newRow("line break") << QStringList{QStringLiteral("one"), QStringLiteral("two\nlines"), QStringLiteral("three")} << false
+                                << QStringList{QStringLiteral("ONE"), QStringLiteral("TWO\nLINES"), QStringLiteral("THREE")} << 2;
+    QTest::newRow("empty text") << QStringList{QStringLiteral("one"), QString(), QStringLiteral("three")} << false
+                                << QStringList{QStringLiteral("ONE"), QString(), QStringLiteral("THREE")} << 1;
+}
+
+// Texts are packed into requests and unpacked from replies by lines, groups with mismatched lines are translated one by one
+void QOnlineTranslatorTest::batchTranslation()
+{
+    QFETCH(QStringList, texts);
+    QFETCH(bool, mergeLines);
+    QFETCH(QStringList, translations);
+    QFETCH(int, requests);
+
+    // Stands in for LibreTranslate that converts texts to upper case and optionally joins lines with spaces
+    int sentRequests = 0;
+    FixtureNetworkManager manager([&](const QNetworkRequest &, const QByteArray &body, int &) {
+        ++sentRequests;
+        QString translation = QUrlQuery(QString::fromLatin1(body)).queryItemValue(QStringLiteral("q"), QUrl::FullyDecoded).toUpper();
+        if (mergeLines)
+            translation.replace('\n', ' ');
+        return QJsonDocument(QJsonObject{{QStringLiteral("translatedText"), translation}}).toJson();
+    });
+
+    QOnlineTranslator translator;
+    translator.setNetworkAccessManager(&manager);
+    translator.setEngineUrl(QOnlineTranslator::LibreTranslate, QStringLiteral("https://libretranslate.test"));
+
+    QEventLoop loop;
+    connect(&translator, &QOnlineTranslator::finished, &loop, &QEventLoop::quit);
+    translator.translateBatch(texts, QOnlineTranslator::LibreTranslate, QOnlineTranslator::German, QOnlineTranslator::English, QOnlineTranslator::English);
+    loop.exec();
+
+    QCOMPARE(translator.batchTranslations(), translations);
+    QCOMPARE(translator.batchErrors(), QVector<QOnlineTranslator::TranslationError>(texts.size(), QOnlineTranslator::NoError));
+    QCOMPARE(sentRequests, requests);
+}
+
+// Older LibreTranslate servers reject "auto" source, the translation is repeated after a separate detection request
+void QOnlineTranslatorTest::libreDetectionFallback()
+{
+    QStringList sentRequests;
+    FixtureNetworkManager manager([&](const QNetworkRequest &request, const QByteArray &body, int &status) {
+        const QUrlQuery query(QString::fromLatin1(body));
+        if (request.url().path() == QLatin1String("/detect")) {
+            sentRequests.append(QStringLiteral("detect"));
+            return QByteArrayLiteral(R"([{"confidence": 90.0, "language": "en"}])");
+        }
+
+        sentRequests.append(QStringLiteral("translate from ") + query.queryItemValue(QStringLiteral("source")));
+        if (query.queryItemValue(QStringLiteral("source")) == QLatin1String("auto")) {
+            status = 400;
+            return QByteArrayLiteral(R"({"error": "auto is not a valid source language"})");
+        }
+
+        const QString translation = query.queryItemValue(QStringLiteral("q"), QUrl::FullyDecoded).toUpper();
+        return QJsonDocument(QJsonObject{{QStringLiteral("translatedText"), translation}}).toJson();
+    });
+
+    QOnlineTranslator translator;
+    translator.setNetworkAccessManager(&manager);
+    translator.setEngineUrl(QOnlineTranslator::LibreTranslate, QStringLiteral("https://libretranslate.test"));
+
+    QEventLoop loop;
+    connect(&translator, &QOnlineTranslator::finished, &loop, &QEventLoop::quit);
+    translator.translate(QStringLiteral("hello"), QOnlineTranslator::LibreTranslate, QOnlineTranslator::German, QOnlineTranslator::Auto, QOnlineTranslator::English);
+    loop.exec();
+
+    QVERIFY2(translator.error() == QOnlineTranslator::NoError, qPrintable(translator.errorString()));
+    QCOMPARE(translator.translation(), QStringLiteral("HELLO"));
+    QCOMPARE(translator.sourceLanguage(), QOnlineTranslator::English);
+    QCOMPARE(sentRequests, QStringList({QStringLiteral("translate from auto"), QStringLiteral("detect"), QStringLiteral("translate from en")}));
+
+    // The server is remembered, so "auto" source is not sent again
+    sentRequests.clear();
+    translator.translate(QStringLiteral("world"), QOnlineTranslator::LibreTranslate, QOnlineTranslator::German, QOnlineTranslator::Auto, QOnlineTranslator::English);
+    loop.exec();
+
+    QVERIFY2(translator.error() == QOnlineTranslator::NoError, qPrintable(translator.errorString()));
+    QCOMPARE(translator.translation(), QStringLiteral("WORLD"));
+    QCOMPARE(sentRequests, QStringList({QStringLiteral("detect"), QStringLiteral("translate from en")}));
+}
+
+void QOnlineTranslatorTest::googleReplyErrors_data()
+{
+    QTest::addColumn<QByteArray>("reply");
+    QTest::addColumn<int>("error");
+
+    QTest::newRow("valid") << QByteArray(R"([[["Hallo","Hello",null,null,10]],null,"en"])") << QOnlineTranslator::NoError;
+    QTest::newRow("html page") << QByteArray("\n<html><body>Our systems have detected unusual traffic</body></html>") << QOnlineTranslator::ServiceError;
+    QTest::newRow("malformed") << QByteArray(R"([[["Hallo","Hello",null,null,10]],null,"en"}})") << QOnlineTranslator::ParsingError;
+    QTest::newRow("truncated") << QByteArray(R"([[["Hallo","Hello",null,null,10]],nu)") << QOnlineTranslator::ParsingError;
+}
+
+// Only HTML pages are reported as blocked traffic, other unreadable replies are parsing errors
+void QOnlineTranslatorTest::googleReplyErrors()
+{
+    QFETCH(QByteArray, reply);
+    QFETCH(int, error);
+
+    FixtureNetworkManager manager([&](const QNetworkRequest &, const QByteArray &, int &) {
+        return reply;
+    });
+
+    QOnlineTranslator translator;
+    translator.setNetworkAccessManager(&manager);
+
+    QEventLoop loop;
+    connect(&translator, &QOnlineTranslator::finished, &loop, &QEventLoop::quit);
+    translator.translate(QStringLiteral("Hello"), QOnlineTranslator::Google, QOnlineTranslator::German, QOnlineTranslator::English, QOnlineTranslator::English);
+    loop.exec();
+
+    QVERIFY2(translator.error() == error, qPrintable(translator.errorString()));
+}
+
+QTestData &QOnlineTranslatorTest::addSupportRow(QOnlineTranslator::Engine engine, QOnlineTranslator::Language lang)
+{
+    return QTest::newRow((name(engine) + ' ' + name(lang)).constData()) << engine << lang;
+}
+
+QByteArray QOnlineTranslatorTest::name(QOnlineTranslator::Engine engine)
+{
+    return QMetaEnum::fromType<QOnlineTranslator::Engine>().valueToKey(engine);
+}
+
+QByteArray QOnlineTranslatorTest::name(QOnlineTranslator::Language lang)
+{
+    return QMetaEnum::fromType<QOnlineTranslator::Language>().valueToKey(lang);
+}
+
+QTEST_GUILESS_MAIN(QOnlineTranslatorTest)
+
+#include "qonlinetranslatortest.moc"